@@ -30,9 +30,15 @@ parallel_algos = []
 t = 2
 while t <= max_threads:
     parallel_algos.append(f"dual_pivot_parallel_{t}")
+    parallel_algos.append(f"radix_sort_parallel_{t}")
+    parallel_algos.append(f"dual_pivot_stable_parallel_{t}")
+    parallel_algos.append(f"dual_pivot_mergesort_parallel_{t}")
     t *= 2
 
-ALGORITHMS = parallel_algos + ["std_sort", "std_stable_sort", "qsort", "dual_pivot_sequential"]
+# Pivot sampling policies of the sequential sort (see include/dpqs/pivot_sampling.hpp)
+sampler_algos = [f"dual_pivot_sequential_{s}" for s in ("extreme", "tertile", "adaptive")]
+
+ALGORITHMS = parallel_algos + ["std_sort", "std_stable_sort", "qsort", "dual_pivot_sequential", "radix_sort", "dual_pivot_stable"] + sampler_algos
 TYPES = ["int", "double"]
 PATTERNS = [
     "RANDOM", "NEARLY_SORTED", "REVERSE_SORTED",
@@ -147,7 +153,7 @@ def run_benchmark():
         print(f"[{i+1}/{total_configs}] Running {algo} {type_} {pattern} {size} ({needed} iterations)...")
 
         threads = 0
-        if algo.startswith("dual_pivot_parallel_"):
+        if algo.startswith(("dual_pivot_parallel_", "radix_sort_parallel_", "dual_pivot_stable_parallel_", "dual_pivot_mergesort_parallel_")):
             try:
                 threads = int(algo.split("_")[-1])
             except ValueError:
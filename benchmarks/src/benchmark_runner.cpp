@@ -37,25 +37,70 @@ std::map<std::string, std::string> parse_args(int argc, char* argv[]) {
     return args;
 }
 
+// Pivot sampling policy selected by an algorithm name suffix, e.g.
+// "dual_pivot_sequential_tertile" or "dual_pivot_parallel_adaptive_8".
+enum class PivotPolicy { Default, Extreme, Tertile, Adaptive };
+
+PivotPolicy pivot_policy(const std::string& algo) {
+    if (algo.find("_extreme") != std::string::npos) return PivotPolicy::Extreme;
+    if (algo.find("_tertile") != std::string::npos) return PivotPolicy::Tertile;
+    if (algo.find("_adaptive") != std::string::npos) return PivotPolicy::Adaptive;
+    return PivotPolicy::Default;
+}
+
 template <typename T>
-void run_test(const std::string& algo, benchmark_data::DataPattern pattern, size_t size, const std::string& output_file, const std::string& type_name, int iterations, int threads) {
-    auto data = benchmark_data::generate_data<T>(size, pattern);
+void run_dual_pivot(const std::string& algo, std::vector<T>& data, int parallelism) {
+    switch (pivot_policy(algo)) {
+        case PivotPolicy::Extreme:
+            dual_pivot::sort_with_sampler<dual_pivot::ExtremePivotSampler>(data, parallelism);
+            break;
+        case PivotPolicy::Tertile:
+            dual_pivot::sort_with_sampler<dual_pivot::TertilePivotSampler>(data, parallelism);
+            break;
+        case PivotPolicy::Adaptive:
+            dual_pivot::sort_with_sampler<dual_pivot::AdaptivePivotSampler>(data, parallelism);
+            break;
+        default:
+            dual_pivot::sort(data, parallelism);
+            break;
+    }
+}
 
-    // Warmup
-    auto warmup_data = data;
+template <typename T>
+void run_algorithm(const std::string& algo, std::vector<T>& data, int threads) {
     if (algo == "std_sort") {
-        std::sort(warmup_data.begin(), warmup_data.end());
+        std::sort(data.begin(), data.end());
     } else if (algo == "std_stable_sort") {
-        std::stable_sort(warmup_data.begin(), warmup_data.end());
+        std::stable_sort(data.begin(), data.end());
     } else if (algo == "qsort") {
-        std::qsort(warmup_data.data(), warmup_data.size(), sizeof(T), compare<T>);
+        std::qsort(data.data(), data.size(), sizeof(T), compare<T>);
     } else if (algo.find("dual_pivot_parallel") != std::string::npos) {
-        dual_pivot::sort(warmup_data, threads);
-    } else if (algo == "dual_pivot_sequential") {
-        dual_pivot::sort(warmup_data, 1);
+        run_dual_pivot(algo, data, threads);
+    } else if (algo.find("dual_pivot_sequential") != std::string::npos) {
+        run_dual_pivot(algo, data, 1);
+    } else if (algo.find("radix_sort_parallel") != std::string::npos) {
+        dual_pivot::radix_sort(data.data(), 0, static_cast<std::ptrdiff_t>(data.size()), threads);
+    } else if (algo == "radix_sort") {
+        dual_pivot::radix_sort(data.data(), 0, static_cast<std::ptrdiff_t>(data.size()), 1);
+    } else if (algo.find("dual_pivot_mergesort_parallel") != std::string::npos) {
+        std::ptrdiff_t size = static_cast<std::ptrdiff_t>(data.size());
+        dual_pivot::parallelMergeSort(data.data(), dual_pivot::getMergeDepth(threads, size >> 12), 0, size, std::less<T>(), threads);
+    } else if (algo.find("dual_pivot_stable_parallel") != std::string::npos) {
+        dual_pivot::stable_sort(data, threads);
+    } else if (algo == "dual_pivot_stable") {
+        dual_pivot::stable_sort(data, 1);
     } else {
-        dual_pivot::sort(warmup_data);
+        dual_pivot::sort(data);
     }
+}
+
+template <typename T>
+void run_test(const std::string& algo, benchmark_data::DataPattern pattern, size_t size, const std::string& output_file, const std::string& type_name, int iterations, int threads) {
+    auto data = benchmark_data::generate_data<T>(size, pattern);
+
+    // Warmup
+    auto warmup_data = data;
+    run_algorithm(algo, warmup_data, threads);
 
     // Correctness Check
     if (!std::is_sorted(warmup_data.begin(), warmup_data.end())) {
@@ -71,19 +116,7 @@ void run_test(const std::string& algo, benchmark_data::DataPattern pattern, size
         auto test_data = data;
 
         auto start = std::chrono::high_resolution_clock::now();
-        if (algo == "std_sort") {
-            std::sort(test_data.begin(), test_data.end());
-        } else if (algo == "std_stable_sort") {
-            std::stable_sort(test_data.begin(), test_data.end());
-        } else if (algo == "qsort") {
-            std::qsort(test_data.data(), test_data.size(), sizeof(T), compare<T>);
-        } else if (algo.find("dual_pivot_parallel") != std::string::npos) {
-            dual_pivot::sort(test_data, threads);
-        } else if (algo == "dual_pivot_sequential") {
-            dual_pivot::sort(test_data, 1);
-        } else {
-            dual_pivot::sort(test_data);
-        }
+        run_algorithm(algo, test_data, threads);
         auto end = std::chrono::high_resolution_clock::now();
         durations.push_back(std::chrono::duration<double, std::milli>(end - start).count());
 
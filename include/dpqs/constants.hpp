@@ -1,6 +1,8 @@
 #ifndef DPQS_CONSTANTS_HPP
 #define DPQS_CONSTANTS_HPP
 
+#include <cstddef>
+
 namespace dual_pivot {
 
 // Constants
@@ -14,10 +16,16 @@ constexpr int COUNTING_SORT_THRESHOLD_SHORT = 3200;
 
 // Missing constants added during refactoring
 constexpr int MIN_PARALLEL_MERGE_PARTS_SIZE = 4096;
+// Parallel merges give each thread at least MIN_PARALLEL_MERGE_CHUNK output elements.
+constexpr std::ptrdiff_t MIN_PARALLEL_MERGE_CHUNK = std::ptrdiff_t(1) << 16;
 constexpr int MIN_FIRST_RUN_SIZE = 16;
 constexpr int MIN_FIRST_RUNS_FACTOR = 7;
 constexpr int MAX_RUN_CAPACITY = 5120;
 constexpr int MIN_RUN_COUNT = 4;
+// Parallel run detection scans chunks of at least MIN_PARALLEL_RUN_SCAN_CHUNK elements per thread.
+constexpr std::ptrdiff_t MIN_PARALLEL_RUN_SCAN_CHUNK = std::ptrdiff_t(1) << 16;
+// stable_sort extends natural runs shorter than MIN_STABLE_RUN_SIZE elements by insertion sort.
+constexpr std::ptrdiff_t MIN_STABLE_RUN_SIZE = 32;
 constexpr int MAX_MIXED_INSERTION_SORT_SIZE = 65;
 constexpr int MIN_TRY_MERGE_SIZE = 4096;
 constexpr int DELTA = 6;
@@ -25,6 +33,75 @@ constexpr int MAX_RECURSION_DEPTH = 384;
 constexpr int MIN_BYTE_COUNTING_SORT_SIZE = 64;
 constexpr int MIN_SHORT_OR_CHAR_COUNTING_SORT_SIZE = 1750;
 
+// Counting sorts with a parallelism above 1 count and fill on several threads, each
+// taking at least MIN_PARALLEL_COUNTING_CHUNK elements (a 2-byte frequency table per
+// thread has 65536 entries to sum).
+constexpr std::ptrdiff_t MIN_PARALLEL_COUNTING_CHUNK = std::ptrdiff_t(1) << 18;
+
+// Number of elements classified per block by the branchless block partitioner.
+// Offsets are stored as bytes, so this must not exceed 256.
+constexpr int BLOCK_PARTITION_SIZE = 128;
+
+// Pattern-defeating safeguards (pdqsort style).
+// A partition is "bad" when one part keeps more than 15/16 of the elements (the
+// extreme-of-five dual pivots already leave 2/3 in the middle part on random data).
+// Every bad partition charges this many extra depth units to 'bits', so repeated bad
+// splits reach the heap sort fallback (MAX_RECURSION_DEPTH) long before 64 levels.
+constexpr int BAD_PARTITION_PENALTY = 4 * DELTA;
+// Maximum number of element moves a "likely sorted" insertion sort probe may spend.
+constexpr int PARTIAL_INSERTION_SORT_LIMIT = 8;
+
+// Adaptive pivot sampling: ranges of at least ADAPTIVE_SAMPLE_MIN_SIZE elements sample
+// about sqrt(size) / ADAPTIVE_SAMPLE_DIVISOR elements, at most MAX_ADAPTIVE_SAMPLE_SIZE.
+constexpr int ADAPTIVE_SAMPLE_MIN_SIZE = 4096;
+constexpr int ADAPTIVE_SAMPLE_DIVISOR = 4;
+constexpr int MAX_ADAPTIVE_SAMPLE_SIZE = 128;
+
+// Parallel sort ranges of at least PARALLEL_PARTITION_THRESHOLD elements are partitioned
+// by several threads, each taking at least MIN_PARALLEL_PARTITION_CHUNK elements.
+constexpr std::ptrdiff_t PARALLEL_PARTITION_THRESHOLD = std::ptrdiff_t(1) << 20;
+constexpr std::ptrdiff_t MIN_PARALLEL_PARTITION_CHUNK = std::ptrdiff_t(1) << 16;
+
+// Parallel samplesort (IPS4o style): ranges of at least SAMPLESORT_THRESHOLD elements are
+// distributed into 2^SAMPLESORT_LOG_BUCKETS buckets in one pass instead of log(n) partitioning
+// passes. Elements move in blocks of SAMPLESORT_BLOCK_BYTES, and the splitters come from a
+// sample of SAMPLESORT_OVERSAMPLING * log2(n) elements per bucket.
+constexpr std::ptrdiff_t SAMPLESORT_THRESHOLD = std::ptrdiff_t(1) << 24;
+constexpr int SAMPLESORT_LOG_BUCKETS = 8;
+constexpr std::size_t SAMPLESORT_BLOCK_BYTES = 2048;
+constexpr double SAMPLESORT_OVERSAMPLING = 0.2;
+
+// Radix sort: RADIX_BITS bits per digit. Ranges of fewer than MIN_RADIX_LSD_SIZE elements
+// are sorted by comparison, ranges of more than MAX_RADIX_LSD_SIZE take an MSD pass before
+// their LSD passes, parallel passes take MIN_PARALLEL_RADIX_CHUNK elements per
+// thread, and sort() picks radix sort for ranges of at least RADIX_SORT_THRESHOLD elements.
+constexpr int RADIX_BITS = 8;
+constexpr std::size_t RADIX_BUCKETS = std::size_t(1) << RADIX_BITS;
+constexpr std::ptrdiff_t MIN_RADIX_LSD_SIZE = 256;
+constexpr std::ptrdiff_t MAX_RADIX_LSD_SIZE = std::ptrdiff_t(1) << 16;
+constexpr std::ptrdiff_t MIN_PARALLEL_RADIX_CHUNK = std::ptrdiff_t(1) << 16;
+constexpr std::ptrdiff_t RADIX_SORT_THRESHOLD = std::ptrdiff_t(1) << 12;
+
+// Scratch buffers of at least MIN_FIRST_TOUCH_BYTES are first touched by the pool
+// in parallel, one write per FIRST_TOUCH_PAGE_SIZE bytes, so their pages spread
+// over the NUMA nodes of the workers instead of landing on the caller's node.
+constexpr std::size_t MIN_FIRST_TOUCH_BYTES = std::size_t(1) << 22;
+constexpr std::size_t FIRST_TOUCH_PAGE_SIZE = 4096;
+
+// Scratch pool (BufferManager): blocks are rounded up to size classes of at least
+// MIN_SCRATCH_BLOCK_BYTES (four classes per power of two) and aligned to SCRATCH_ALIGNMENT
+// bytes, or to HUGE_PAGE_SIZE from one huge page up. Each thread keeps up to
+// MAX_CACHED_SCRATCH_BLOCKS freed blocks, MAX_CACHED_SCRATCH_BYTES in total, for later sorts.
+constexpr std::size_t MIN_SCRATCH_BLOCK_BYTES = 4096;
+constexpr std::size_t SCRATCH_ALIGNMENT = 64;
+constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(1) << 21;
+constexpr std::size_t MAX_CACHED_SCRATCH_BLOCKS = 32;
+constexpr std::size_t MAX_CACHED_SCRATCH_BYTES = std::size_t(1) << 28;
+
+// Fork/join task trees (parallel/completer.hpp) carve their nodes from chunks of the scratch
+// pool, the first NODE_ARENA_CHUNK_BYTES bytes large and each further one twice the last.
+constexpr std::size_t NODE_ARENA_CHUNK_BYTES = std::size_t(1) << 14;
+
 } // namespace dual_pivot
 
 #endif // DPQS_CONSTANTS_HPP
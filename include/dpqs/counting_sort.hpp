@@ -2,11 +2,129 @@
 #define DPQS_COUNTING_SORT_HPP
 
 #include "dpqs/utils.hpp"
+#include "dpqs/constants.hpp"
+#include "dpqs/cpu_features.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <type_traits>
 
+#if DPQS_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace dual_pivot {
 
+/**
+ * @brief Frequency table of NUM_VALUES entries owned by the calling thread.
+ *
+ * Every counting sort leaves the table all zero again (the fill clears each
+ * entry it consumes), so a call costs neither an allocation nor a clear.
+ */
+template<int NUM_VALUES>
+std::ptrdiff_t* counting_histogram() {
+    thread_local std::vector<std::ptrdiff_t> counts(NUM_VALUES, 0);
+    return counts.data();
+}
+
+/**
+ * @brief Adds the frequencies of array[begin, end) to counts (indexed by value + OFFSET).
+ *
+ * Runs of equal values would make every increment wait for the store of the
+ * previous one, so large ranges count into four interleaved 32-bit sub-tables
+ * (thread-local, kept zero like counting_histogram), unrolled by four, and
+ * merge them into counts at the end. Ranges smaller than the sub-tables count
+ * directly.
+ */
+template<typename T>
+void count_values(const T* array, std::ptrdiff_t begin, std::ptrdiff_t end, std::ptrdiff_t* counts) {
+    static constexpr int NUM_VALUES = 1 << (8 * sizeof(T));
+    static constexpr int OFFSET = std::is_signed<T>::value ? (1 << (8 * sizeof(T) - 1)) : 0;
+    static constexpr int LANES = 4;
+
+    if (end - begin < static_cast<std::ptrdiff_t>(LANES) * NUM_VALUES) {
+        for (std::ptrdiff_t i = begin; i < end; ++i) {
+            counts[static_cast<int>(array[i]) + OFFSET]++;
+        }
+        return;
+    }
+
+    thread_local std::vector<std::uint32_t> lane_counts(static_cast<std::size_t>(LANES) * NUM_VALUES, 0);
+    std::uint32_t* lanes = lane_counts.data();
+    std::uint32_t* lane0 = lanes + OFFSET;
+    std::uint32_t* lane1 = lane0 + NUM_VALUES;
+    std::uint32_t* lane2 = lane1 + NUM_VALUES;
+    std::uint32_t* lane3 = lane2 + NUM_VALUES;
+
+    // Blocks keep the 32-bit sub-tables from overflowing
+    static constexpr std::ptrdiff_t BLOCK = std::ptrdiff_t(1) << 30;
+    for (std::ptrdiff_t from = begin; from < end; from += BLOCK) {
+        std::ptrdiff_t to = std::min(end, from + BLOCK);
+        std::ptrdiff_t i = from;
+        for (; i + LANES <= to; i += LANES) {
+            // Loads first: byte loads may alias the counters
+            int v0 = static_cast<int>(array[i]);
+            int v1 = static_cast<int>(array[i + 1]);
+            int v2 = static_cast<int>(array[i + 2]);
+            int v3 = static_cast<int>(array[i + 3]);
+            lane0[v0]++;
+            lane1[v1]++;
+            lane2[v2]++;
+            lane3[v3]++;
+        }
+        for (; i < to; ++i) {
+            lane0[static_cast<int>(array[i])]++;
+        }
+
+        for (int v = 0; v < NUM_VALUES; ++v) {
+            std::ptrdiff_t total = 0;
+            for (int lane = 0; lane < LANES; ++lane) {
+                total += lanes[lane * NUM_VALUES + v];
+                lanes[lane * NUM_VALUES + v] = 0;
+            }
+            counts[v] += total;
+        }
+    }
+}
+
+#if DPQS_HAS_X86_SIMD
+template<typename T>
+DPQS_TARGET_AVX2 inline void fill_run_avx2(T* p, std::ptrdiff_t n, T value) {
+    static constexpr std::ptrdiff_t VECTOR = 32 / sizeof(T);
+    const __m256i v = (sizeof(T) == 1) ? _mm256_set1_epi8(static_cast<char>(value))
+                                       : _mm256_set1_epi16(static_cast<short>(value));
+    std::ptrdiff_t i = 0;
+    for (; i + VECTOR <= n; i += VECTOR) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), v);
+    }
+    // The tail overlaps the last full store
+    if (i < n) _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + n - VECTOR), v);
+}
+#endif
+
+/**
+ * @brief Writes n copies of value to p.
+ *
+ * Runs of at least one vector use 32-byte stores when the CPU has AVX2
+ * (vector = true, see simd_level()), shorter runs a scalar loop.
+ */
+template<typename T>
+inline void fill_run(T* p, std::ptrdiff_t n, T value, bool vector) {
+#if DPQS_HAS_X86_SIMD
+    if (vector && n >= static_cast<std::ptrdiff_t>(32 / sizeof(T))) {
+        fill_run_avx2(p, n, value);
+        return;
+    }
+#else
+    (void)vector;
+#endif
+    while (n-- > 0) {
+        *p++ = value;
+    }
+}
+
 /**
  * @brief Sorts a range of the array using Counting Sort for byte-sized elements.
  *
@@ -35,16 +153,12 @@ counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index) {
     // OFFSET = 1 << (8*1 - 1) = 1 << 7 = 128.
     static constexpr int OFFSET = std::is_signed<T>::value ? (1 << (8 * sizeof(T) - 1)) : 0;
 
-    std::vector<int> frequency_count(NUM_VALUES, 0);
+    std::ptrdiff_t* frequency_count = counting_histogram<NUM_VALUES>();
 
-    // Calculate frequencies
-    for (std::ptrdiff_t i = end_index; i > start_index; ) {
-        // Use integer cast and offset to map values to [0, 255] range
-        // For signed char: -128 + 128 = 0, 127 + 128 = 255
-        int val = static_cast<int>(array[--i]);
-        int idx = val + OFFSET;
-        frequency_count[idx]++;
-    }
+    // Calculate frequencies: value + OFFSET maps the values to [0, 255]
+    // For signed char: -128 + 128 = 0, 127 + 128 = 255
+    count_values(array, start_index, end_index, frequency_count);
+    const bool vector = simd_level() != SimdLevel::None;
 
     std::ptrdiff_t size = end_index - start_index;
     // Optimization: Choose iteration direction based on array density.
@@ -56,10 +170,10 @@ counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index) {
         std::ptrdiff_t write_index = end_index;
         for (int i = NUM_VALUES; --i >= 0; ) {
             T value = static_cast<T>(i - OFFSET);
-            int element_count = frequency_count[i];
-            while (element_count-- > 0) {
-                array[--write_index] = value;
-            }
+            std::ptrdiff_t element_count = frequency_count[i];
+            frequency_count[i] = 0;
+            write_index -= element_count;
+            fill_run(array + write_index, element_count, value, vector);
         }
     } else {
         // Case 2: Sparse Array.
@@ -68,10 +182,10 @@ counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index) {
         for (int i = 0; i < NUM_VALUES; i++) {
             if (frequency_count[i] > 0) {
                 T value = static_cast<T>(i - OFFSET);
-                int element_count = frequency_count[i];
-                while (element_count-- > 0) {
-                    array[write_index++] = value;
-                }
+                std::ptrdiff_t element_count = frequency_count[i];
+                frequency_count[i] = 0;
+                fill_run(array + write_index, element_count, value, vector);
+                write_index += element_count;
             }
         }
     }
@@ -104,40 +218,113 @@ counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index) {
     // OFFSET = 1 << 15 = 32768.
     static constexpr int OFFSET = std::is_signed<T>::value ? (1 << 15) : 0;
 
-    std::vector<int> frequency_count(NUM_VALUES, 0);
+    std::ptrdiff_t* frequency_count = counting_histogram<NUM_VALUES>();
 
     // Calculate frequencies
-    for (int i = end_index; i > start_index; ) {
-        int val = static_cast<int>(array[--i]);
-        int idx = val + OFFSET;
-        frequency_count[idx]++;
-    }
+    count_values(array, start_index, end_index, frequency_count);
+    const bool vector = simd_level() != SimdLevel::None;
 
-    int size = end_index - start_index;
+    std::ptrdiff_t size = end_index - start_index;
     // Optimization: Choose iteration direction based on array density.
     if (size > NUM_VALUES / 2) {
         // Dense: iterate backwards and fill from end
-        int write_index = end_index;
+        std::ptrdiff_t write_index = end_index;
         for (int i = NUM_VALUES; --i >= 0; ) {
             T value = static_cast<T>(i - OFFSET);
-            int element_count = frequency_count[i];
-            while (element_count-- > 0) {
-                array[--write_index] = value;
-            }
+            std::ptrdiff_t element_count = frequency_count[i];
+            frequency_count[i] = 0;
+            write_index -= element_count;
+            fill_run(array + write_index, element_count, value, vector);
         }
     } else {
         // Sparse: iterate forwards and fill from start
-        int write_index = start_index;
+        std::ptrdiff_t write_index = start_index;
         for (int i = 0; i < NUM_VALUES; i++) {
             if (frequency_count[i] > 0) {
                 T value = static_cast<T>(i - OFFSET);
-                int element_count = frequency_count[i];
-                while (element_count-- > 0) {
-                    array[write_index++] = value;
-                }
+                std::ptrdiff_t element_count = frequency_count[i];
+                frequency_count[i] = 0;
+                fill_run(array + write_index, element_count, value, vector);
+                write_index += element_count;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Counting Sort of 1- or 2-byte integral elements on several threads.
+ *
+ * 1. Every thread counts one chunk of the range into its own frequency table.
+ * 2. The tables are summed, each thread taking a slice of the values, and the
+ *    prefix sum gives the first output position of every value.
+ * 3. The output range is cut into equal parts; each thread finds the value at
+ *    the start of its part and fills the part.
+ *
+ * Ranges with fewer than MIN_PARALLEL_COUNTING_CHUNK elements per thread use
+ * the sequential counting_sort.
+ *
+ * @tparam T The type of elements in the array (1 or 2 bytes).
+ * @param array The array to sort.
+ * @param start_index The inclusive start index of the range.
+ * @param end_index The exclusive end index of the range.
+ * @param parallelism Number of threads to use (0 or 1 for sequential).
+ */
+template<typename T>
+#if __cplusplus >= 202002L
+requires (std::is_integral_v<T> && sizeof(T) <= 2)
+void parallel_counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index, int parallelism) {
+#else
+typename std::enable_if<std::is_integral<T>::value && sizeof(T) <= 2, void>::type
+parallel_counting_sort(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index, int parallelism) {
+#endif
+    static constexpr int NUM_VALUES = 1 << (8 * sizeof(T));
+    static constexpr int OFFSET = std::is_signed<T>::value ? (1 << (8 * sizeof(T) - 1)) : 0;
+
+    std::ptrdiff_t size = end_index - start_index;
+    std::ptrdiff_t threads = parallelism > 1 ? std::min<std::ptrdiff_t>(parallelism, size / MIN_PARALLEL_COUNTING_CHUNK) : 1;
+    if (threads < 2) {
+        counting_sort(array, start_index, end_index);
+        return;
+    }
+    int chunks = static_cast<int>(threads);
+    auto& pool = getThreadPool(parallelism);
+
+    // Phase 1: one frequency table per chunk
+    std::vector<std::ptrdiff_t> counts(static_cast<std::size_t>(chunks) * NUM_VALUES, 0);
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        count_values(array, start_index + size * i / chunks, start_index + size * (i + 1) / chunks,
+                     counts.data() + static_cast<std::size_t>(i) * NUM_VALUES);
+    });
+
+    // Phase 2: totals into the first table
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        for (int v = NUM_VALUES * i / chunks, end = NUM_VALUES * (i + 1) / chunks; v < end; ++v) {
+            std::ptrdiff_t total = counts[v];
+            for (int j = 1; j < chunks; ++j) {
+                total += counts[static_cast<std::size_t>(j) * NUM_VALUES + v];
             }
+            counts[v] = total;
         }
+    });
+
+    std::vector<std::ptrdiff_t> starts(NUM_VALUES + 1);
+    starts[0] = start_index;
+    for (int v = 0; v < NUM_VALUES; ++v) {
+        starts[v + 1] = starts[v] + counts[v];
     }
+
+    // Phase 3: fill equal parts of the output
+    const bool vector = simd_level() != SimdLevel::None;
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        std::ptrdiff_t from = start_index + size * i / chunks;
+        std::ptrdiff_t to = start_index + size * (i + 1) / chunks;
+        int v = static_cast<int>(std::upper_bound(starts.begin(), starts.end(), from) - starts.begin()) - 1;
+        for (std::ptrdiff_t k = from; k < to; ++v) {
+            std::ptrdiff_t end = std::min(starts[v + 1], to);
+            fill_run(array + k, end - k, static_cast<T>(v - OFFSET), vector);
+            k = end;
+        }
+    });
 }
 
 } // namespace dual_pivot
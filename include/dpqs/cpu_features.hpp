@@ -0,0 +1,52 @@
+#ifndef DPQS_CPU_FEATURES_HPP
+#define DPQS_CPU_FEATURES_HPP
+
+// x86 SIMD kernels are compiled with per-function target attributes and selected
+// at runtime, so the library does not depend on the -march flags of the build.
+// Define DPQS_DISABLE_SIMD to compile the scalar kernels only.
+#if !defined(DPQS_DISABLE_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define DPQS_HAS_X86_SIMD 1
+    #define DPQS_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+    #define DPQS_TARGET_AVX512 __attribute__((target("avx512f,avx2,popcnt")))
+#else
+    #define DPQS_HAS_X86_SIMD 0
+    #define DPQS_TARGET_AVX2
+    #define DPQS_TARGET_AVX512
+#endif
+
+namespace dual_pivot {
+
+/**
+ * @brief Widest vector instruction set usable on the running CPU.
+ */
+enum class SimdLevel {
+    None,    ///< Scalar kernels only
+    AVX2,    ///< 256-bit vectors
+    AVX512   ///< 512-bit vectors with mask registers (AVX-512F)
+};
+
+/**
+ * @brief Detects the SIMD level of the running CPU.
+ *
+ * The detection runs once; later calls return the cached result. The compiler
+ * builtin also checks that the operating system saves the extended register state.
+ *
+ * @return The widest supported SimdLevel.
+ */
+inline SimdLevel simd_level() {
+#if DPQS_HAS_X86_SIMD
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        return SimdLevel::None;
+    }();
+    return level;
+#else
+    return SimdLevel::None;
+#endif
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_CPU_FEATURES_HPP
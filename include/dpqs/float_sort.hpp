@@ -3,6 +3,10 @@
 
 #include "dpqs/utils.hpp"
 #include "dpqs/sequential_sorters.hpp"
+#include "dpqs/parallel/parallel_sort.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
+#include "dpqs/parallel/samplesort.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <type_traits>
@@ -45,6 +49,23 @@ bool is_positive_zero(T value) {
     return value == 0 && !is_negative_zero(value);
 }
 
+/**
+ * @brief Order produced by sort_floats: -0.0 before +0.0 and NaNs after everything else.
+ *
+ * A strict weak order on all values (std::less is not one once NaNs appear), so
+ * it is also the right comparator to check whether a float range is already sorted.
+ *
+ * @tparam T The floating-point type.
+ * @return true if x sorts before y.
+ */
+template<typename T>
+bool float_total_less(T x, T y) {
+    if (is_nan(x)) return false;
+    if (is_nan(y)) return true;
+    if (x < y) return true;
+    return x == y && std::signbit(x) && !std::signbit(y);
+}
+
 /**
  * @brief Reinterprets the bits of an unsigned int as a float.
  *
@@ -149,21 +170,96 @@ sort_floats(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index) {
         // Find where the zeros begin (after the last negative number)
         std::ptrdiff_t insertion_index = find_zero_insertion_point(array, start_index, effective_end_index - 1);
 
-        // Replace the first 'negative_zero_count' zeros with -0.0
+        // Replace the first 'negative_zero_count' zeros with -0.0 (any floating-point type)
+        const T negative_zero = std::copysign(T(0), T(-1));
         for (std::ptrdiff_t i = 0; i < negative_zero_count && insertion_index < effective_end_index; i++, insertion_index++) {
-            if constexpr (std::is_same_v<T, float>) {
-                if (is_positive_zero(array[insertion_index])) {
-                    array[insertion_index] = bits_to_float(0x80000000U);
-                }
-            } else if constexpr (std::is_same_v<T, double>) {
-                if (is_positive_zero(array[insertion_index])) {
-                    array[insertion_index] = bits_to_double(0x8000000000000000ULL);
-                }
+            if (is_positive_zero(array[insertion_index])) {
+                array[insertion_index] = negative_zero;
             }
         }
     }
 }
 
+/**
+ * @brief Parallel version of sort_floats with the same result.
+ *
+ * 1. NaNs are moved to the end by a parallel partition (parallel_partition_pass).
+ * 2. The other values are sorted with std::less by the parallel quicksort, or by
+ *    samplesort from SAMPLESORT_THRESHOLD elements. -0.0 and +0.0 compare equal,
+ *    so they end up mixed in one run of zeros.
+ * 3. The threads count the -0.0 in that run and rewrite it as -0.0 first, then +0.0.
+ *
+ * Uses sort_floats for parallelism <= 1 and small ranges. (dual_pivot::sort sorts
+ * large float and double arrays by radix_sort, whose integer keys already give
+ * this order; this is the comparison path for the other floating-point types.)
+ *
+ * @tparam T The floating-point type.
+ * @param array The array to sort.
+ * @param start_index The inclusive start index of the range.
+ * @param end_index The exclusive end index of the range.
+ * @param parallelism Number of threads to use.
+ */
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, void>::type
+parallel_sort_floats(T* array, std::ptrdiff_t start_index, std::ptrdiff_t end_index, int parallelism) {
+    std::ptrdiff_t size = end_index - start_index;
+    if (parallelism <= 1 || size <= MIN_PARALLEL_SORT_SIZE) {
+        sort_floats(array, start_index, end_index);
+        return;
+    }
+    auto& pool = getThreadPool(parallelism);
+    auto threads_for = [parallelism](std::ptrdiff_t length) {
+        return static_cast<int>(std::max<std::ptrdiff_t>(1, std::min<std::ptrdiff_t>(parallelism, length / MIN_PARALLEL_PARTITION_CHUNK)));
+    };
+
+    // Phase 1: NaNs to the end
+    auto is_number = [](const T& value, const T&) { return !is_nan(value); };
+    const T unused = T(0);
+    int chunks = threads_for(size);
+    std::ptrdiff_t finite_end = chunks > 1
+        ? parallel_partition_pass<true, ScalarBlockClassifier>(array, start_index, end_index, unused, is_number, pool, chunks)
+        : partition_block_pass<true, ScalarBlockClassifier>(array, start_index, end_index, unused, is_number);
+
+    // Phase 2: sort the numbers
+    std::ptrdiff_t finite = finite_end - start_index;
+    if (finite <= MIN_PARALLEL_SORT_SIZE) {
+        sort_sequential<T, std::less<T>>(nullptr, array, 0, start_index, finite_end, std::less<T>());
+    } else {
+        int depth = getDepth(parallelism, finite >> 12);
+        if (finite >= SAMPLESORT_THRESHOLD) {
+            parallelSampleSort(array, depth, start_index, finite_end, std::less<T>(), parallelism);
+        } else {
+            parallelQuickSort(array, depth, start_index, finite_end, std::less<T>(), parallelism);
+        }
+    }
+
+    // Phase 3: -0.0 before +0.0 within the zeros
+    std::pair<T*, T*> zeros = std::equal_range(array + start_index, array + finite_end, T(0));
+    std::ptrdiff_t zero_begin = zeros.first - array;
+    std::ptrdiff_t zero_count = zeros.second - zeros.first;
+    if (zero_count == 0) return;
+
+    chunks = threads_for(zero_count);
+    std::vector<std::ptrdiff_t> negative(chunks, 0);
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        std::ptrdiff_t count = 0;
+        for (std::ptrdiff_t k = zero_begin + zero_count * i / chunks, end = zero_begin + zero_count * (i + 1) / chunks; k < end; ++k) {
+            count += std::signbit(array[k]) ? 1 : 0;
+        }
+        negative[i] = count;
+    });
+    std::ptrdiff_t negative_end = zero_begin;
+    for (std::ptrdiff_t count : negative) negative_end += count;
+    if (negative_end == zero_begin) return;
+
+    const T negative_zero = std::copysign(T(0), T(-1));
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        for (std::ptrdiff_t k = zero_begin + zero_count * i / chunks, end = zero_begin + zero_count * (i + 1) / chunks; k < end; ++k) {
+            array[k] = k < negative_end ? negative_zero : T(0);
+        }
+    });
+}
+
 } // namespace dual_pivot
 
 #endif // DPQS_FLOAT_SORT_HPP
@@ -2,6 +2,7 @@
 #define DPQS_INSERTION_SORT_HPP
 
 #include "utils.hpp"
+#include "constants.hpp"
 
 namespace dual_pivot {
 
@@ -163,6 +164,43 @@ void mixed_insertion_sort(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare
     }
 }
 
+/**
+ * @brief Insertion sort that gives up once it has moved too many elements.
+ *
+ * Used as a cheap "likely sorted" probe after a partitioning step that looked
+ * like it ran over already ordered data. Sorting a range that is in order costs
+ * one comparison per element; as soon as more than PARTIAL_INSERTION_SORT_LIMIT
+ * element moves have been spent the probe stops and reports failure. The range is
+ * always left as a permutation of its input, partially sorted.
+ *
+ * @tparam T Element type (must support comparison and assignment).
+ * @param a Pointer to the array to sort.
+ * @param low Starting index (inclusive).
+ * @param high Ending index (exclusive).
+ * @param comp Comparator instance.
+ * @return true if the range is now sorted, false if the probe gave up.
+ */
+template<typename T, typename Compare>
+bool partial_insertion_sort(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp) {
+    std::ptrdiff_t moves = 0;
+    for (std::ptrdiff_t k = low + 1; k < high; ++k) {
+        if (comp(a[k], a[k - 1])) {
+            T ak = a[k];
+            std::ptrdiff_t i = k;
+            do {
+                a[i] = a[i - 1];
+            } while (--i > low && comp(ak, a[i - 1]));
+            a[i] = ak;
+
+            moves += k - i;
+            if (moves > PARTIAL_INSERTION_SORT_LIMIT) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Specialized insertion sort for int.
  */
@@ -3,36 +3,37 @@
 
 #include <iterator>
 #include <algorithm>
+#include <functional>
 #include <utility>
 #include "dpqs/utils.hpp"
 
 namespace dual_pivot {
 
-template<typename RandomAccessIterator>
-void insertion_sort_iterator(RandomAccessIterator first, RandomAccessIterator last) {
+template<typename RandomAccessIterator, typename Compare = std::less<>>
+void insertion_sort_iterator(RandomAccessIterator first, RandomAccessIterator last, Compare comp = Compare()) {
     if (first == last) return;
     for (RandomAccessIterator i = first + 1; i != last; ++i) {
-        if (*i < *(i - 1)) {
+        if (comp(*i, *(i - 1))) {
             auto val = std::move(*i);
             RandomAccessIterator j = i;
             do {
                 *j = std::move(*(j - 1));
                 --j;
-            } while (j != first && val < *(j - 1));
+            } while (j != first && comp(val, *(j - 1)));
             *j = std::move(val);
         }
     }
 }
 
-template<typename RandomAccessIterator>
-std::pair<RandomAccessIterator, RandomAccessIterator> partition_dual_pivot_iterator(RandomAccessIterator first, RandomAccessIterator last) {
+template<typename RandomAccessIterator, typename Compare = std::less<>>
+std::pair<RandomAccessIterator, RandomAccessIterator> partition_dual_pivot_iterator(RandomAccessIterator first, RandomAccessIterator last, Compare comp = Compare()) {
     std::ptrdiff_t len = std::distance(first, last);
     if (len <= 1) return {first, first};
 
     RandomAccessIterator p1_iter = first;
     RandomAccessIterator p2_iter = last - 1;
 
-    if (*p2_iter < *p1_iter) {
+    if (comp(*p2_iter, *p1_iter)) {
         std::iter_swap(p1_iter, p2_iter);
     }
 
@@ -44,11 +45,11 @@ std::pair<RandomAccessIterator, RandomAccessIterator> partition_dual_pivot_itera
     RandomAccessIterator i = lt;
 
     while (i <= gt) {
-        if (*i < pivot1) {
+        if (comp(*i, pivot1)) {
             std::iter_swap(i, lt);
             ++lt;
             ++i;
-        } else if (*i > pivot2) {
+        } else if (comp(pivot2, *i)) {
             std::iter_swap(i, gt);
             --gt;
         } else {
@@ -64,20 +65,20 @@ std::pair<RandomAccessIterator, RandomAccessIterator> partition_dual_pivot_itera
     return {lt, gt};
 }
 
-template<typename RandomAccessIterator>
-void sort_iterator(RandomAccessIterator first, RandomAccessIterator last) {
+template<typename RandomAccessIterator, typename Compare = std::less<>>
+void sort_iterator(RandomAccessIterator first, RandomAccessIterator last, Compare comp = Compare()) {
     std::ptrdiff_t len = std::distance(first, last);
     
     if (len < 27) {
-        insertion_sort_iterator(first, last);
+        insertion_sort_iterator(first, last, comp);
         return;
     }
 
-    auto pivots = partition_dual_pivot_iterator(first, last);
+    auto pivots = partition_dual_pivot_iterator(first, last, comp);
     
-    sort_iterator(first, pivots.first);
-    sort_iterator(pivots.first + 1, pivots.second);
-    sort_iterator(pivots.second + 1, last);
+    sort_iterator(first, pivots.first, comp);
+    sort_iterator(pivots.first + 1, pivots.second, comp);
+    sort_iterator(pivots.second + 1, last, comp);
 }
 
 } // namespace dual_pivot
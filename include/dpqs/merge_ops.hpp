@@ -2,30 +2,119 @@
 #define DPQS_MERGE_OPS_HPP
 
 #include <algorithm>
+#include <functional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "dpqs/constants.hpp"
+#include "dpqs/cpu_features.hpp"
+#include "dpqs/simd_merge.hpp"
 #include "dpqs/parallel/threadpool.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
 
 namespace dual_pivot {
 
+/**
+ * @brief Copies what is left of either segment after a merge loop.
+ *
+ * A segment already in place (dst is its array and the output has caught up
+ * with it) is not copied.
+ */
+template<typename T>
+inline void merge_tail(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2) {
+    // Buffer overlap check prevents unnecessary copying when dst == a1
+    if (dst != a1 || k < lo1) {
+        while (lo1 < hi1) {
+            dst[k++] = a1[lo1++];
+        }
+    }
+
+    // Buffer overlap check prevents unnecessary copying when dst == a2
+    if (dst != a2 || k < lo2) {
+        while (lo2 < hi2) {
+            dst[k++] = a2[lo2++];
+        }
+    }
+}
+
+/**
+ * @brief Merge kernel using the comparator as a branch (any element type).
+ */
+struct ComparatorMergeKernel {
+    template<typename T, typename Compare>
+    static void merge(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
+        while (lo1 < hi1 && lo2 < hi2) {
+            dst[k++] = comp(a1[lo1], a2[lo2]) ? a1[lo1++] : a2[lo2++];
+        }
+        merge_tail(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+    }
+};
+
+/**
+ * @brief Branch-free merge kernel for arithmetic types.
+ *
+ * Both heads are loaded, the comparison result selects the output (a
+ * conditional move) and advances one of the indices, so random runs cause no
+ * branch mispredictions.
+ */
+struct BranchlessMergeKernel {
+    template<typename T, typename Compare>
+    static void merge(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
+        static_assert(std::is_arithmetic_v<T>, "branch-free merge kernel handles arithmetic types");
+        while (lo1 < hi1 && lo2 < hi2) {
+            const T x = a1[lo1];
+            const T y = a2[lo2];
+            const bool first = comp(x, y);
+            dst[k++] = first ? x : y;
+            lo1 += first;
+            lo2 += !first;
+        }
+        merge_tail(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+    }
+};
+
+#if DPQS_HAS_X86_SIMD
+/**
+ * @brief AVX2 bitonic merge kernel (see use_bitonic_merge_v).
+ *
+ * Merges 8 + 8 keys per step with the network of merge_bitonic_avx2 and
+ * finishes with the branch-free kernel. The CPU must support AVX2.
+ */
+struct Avx2BitonicMergeKernel {
+    template<typename T, typename Compare>
+    static void merge(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
+        static_assert(use_bitonic_merge_v<T, Compare>, "bitonic merge kernel handles 4-byte integers in std::less order");
+        if (hi1 - lo1 >= 8 && hi2 - lo2 >= 8) {
+            merge_bitonic_avx2(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+        }
+        BranchlessMergeKernel::merge(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    }
+};
+#endif
+
+/**
+ * @brief Merges two sorted segments with the given merge kernel.
+ *
+ * Same contract as merge_parts; lets callers and benchmarks pick
+ * ComparatorMergeKernel, BranchlessMergeKernel or Avx2BitonicMergeKernel.
+ */
+template<typename Kernel, typename T, typename Compare>
+void merge_parts_with(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
+    Kernel::merge(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+}
+
 /**
  * @brief Sequential merge operation for combining two sorted array segments
  *
  * This function merges two sorted array segments into a destination array.
- * It uses the standard two-pointer merge technique optimized for cache performance.
- * The implementation includes buffer management optimizations to handle cases
- * where the destination overlaps with source arrays.
+ * On equal keys the element of the second segment goes first. The destination
+ * may be the array of a source segment when the output does not overtake the
+ * reads (the run merger merges into the array that holds a2 this way).
  *
- * Algorithm: Standard merge with three phases:
- * 1. Merge while both arrays have elements (main merge loop)
- * 2. Copy remaining elements from first array if any
- * 3. Copy remaining elements from second array if any
- *
- * Buffer Management:
- * - Handles overlapping destination and source arrays safely
- * - Optimizes for cases where destination is the same as source
- * - Prevents unnecessary copying when arrays don't overlap
+ * Kernel selection:
+ * - 4-byte integers with std::less: AVX2 bitonic network when the CPU has AVX2
+ * - Other arithmetic types: branch-free scalar kernel
+ * - Everything else: comparator branch
  *
  * Time Complexity: O(n + m) where n and m are the sizes of the two segments
  * Space Complexity: O(1) additional space
@@ -42,55 +131,76 @@ namespace dual_pivot {
  */
 template<typename T, typename Compare>
 void merge_parts(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
-    // Phase 1: Main merge loop - process both arrays while they have elements
-    // Uses branch-free comparison for better performance on modern CPUs
-    while (lo1 < hi1 && lo2 < hi2) {
-        dst[k++] = comp(a1[lo1], a2[lo2]) ? a1[lo1++] : a2[lo2++];
+#if DPQS_HAS_X86_SIMD
+    if constexpr (use_bitonic_merge_v<T, Compare>) {
+        if (simd_level() != SimdLevel::None) {
+            Avx2BitonicMergeKernel::merge(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+            return;
+        }
     }
+#endif
+    if constexpr (std::is_arithmetic_v<T>) {
+        BranchlessMergeKernel::merge(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    } else {
+        ComparatorMergeKernel::merge(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    }
+}
 
-    // Phase 2: Copy remaining elements from first array
-    // Buffer overlap check prevents unnecessary copying when dst == a1
-    if (dst != a1 || k < lo1) {
-        while (lo1 < hi1) {
-            dst[k++] = a1[lo1++];
-        }
+/**
+ * @brief Merge order that keeps equal keys in segment order (stable merges).
+ *
+ * merge_parts and merge_path_split take the element of a1 when the comparator
+ * holds for (a1, a2); with this order that is whenever the element of a2 is not
+ * less than it, so on equal keys the element of the first segment goes first.
+ * Only meant for merging: it is not a strict weak ordering.
+ */
+template<typename Compare>
+struct StableMergeOrder {
+    Compare comp;
+
+    template<typename T>
+    bool operator()(const T& x, const T& y) const {
+        return !comp(y, x);
     }
+};
 
-    // Phase 3: Copy remaining elements from second array
-    // Buffer overlap check prevents unnecessary copying when dst == a2
-    if (dst != a2 || k < lo2) {
-        while (lo2 < hi2) {
-            dst[k++] = a2[lo2++];
+/**
+ * @brief Co-rank of an output position (merge path split).
+ *
+ * Returns how many of the first 'i' elements of the merge of a1[lo1, lo1 + n1)
+ * and a2[lo2, lo2 + n2) come from a1, for the tie rule of merge_parts (on equal
+ * keys the element of a2 goes first). Binary search over the diagonal i of the
+ * merge path, O(log(min(n1, n2))) comparisons.
+ */
+template<typename T, typename Compare>
+std::ptrdiff_t merge_path_split(std::ptrdiff_t i, const T* a1, std::ptrdiff_t lo1, std::ptrdiff_t n1,
+                                const T* a2, std::ptrdiff_t lo2, std::ptrdiff_t n2, Compare comp) {
+    std::ptrdiff_t low = std::max<std::ptrdiff_t>(0, i - n2);
+    std::ptrdiff_t high = std::min(i, n1);
+    while (low < high) {
+        std::ptrdiff_t mid = low + ((high - low) >> 1);
+        // The (mid + 1)-th element of a1 is in the prefix if it goes before a2[i - mid - 1]
+        if (comp(a1[lo1 + mid], a2[lo2 + i - mid - 1])) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
+    return low;
 }
 
 /**
- * @brief Parallel merge operation using divide-and-conquer with binary search
+ * @brief Parallel merge of two sorted segments (merge path).
  *
- * This function implements a parallel merge algorithm that recursively divides
- * large merge operations into smaller subproblems that can be processed concurrently.
- * It uses binary search to find optimal split points that balance workload.
+ * The output is cut into equal chunks, one per thread. Each thread finds the
+ * co-ranks of its chunk boundaries with merge_path_split and merges its part
+ * with merge_parts, so the result is the same as that of merge_parts and the
+ * work is balanced whatever the key distribution.
  *
- * Algorithm Strategy:
- * 1. Check if both segments are large enough for parallel processing
- * 2. Ensure the first array is the larger one (swap if necessary)
- * 3. Find median element of larger array and binary search position in smaller array
- * 4. Launch parallel tasks for the two resulting merge operations
- * 5. Fall back to sequential merge for small segments
- *
- * Parallel Subdivision:
- * - Uses binary search (std::lower_bound) to find split points
- * - Ensures balanced workload distribution between threads
- * - Maintains cache locality by processing related data together
- *
- * Load Balancing:
- * - Always makes the larger array the primary partitioning source
- * - Uses median split to ensure roughly equal work distribution
- * - Recursive subdivision continues until segments are too small for parallelism
- *
- * Time Complexity: O(log(n+m)) depth with O(n+m) total work
- * Space Complexity: O(log(n+m)) recursion stack space
+ * Falls back to merge_parts when fewer than two threads would get
+ * MIN_PARALLEL_MERGE_CHUNK elements each, and when the output overlaps a
+ * source segment (the run merger writes over the run it is still reading,
+ * which only the sequential order makes safe).
  *
  * @tparam T Element type (must support comparison and assignment)
  * @tparam Compare Comparator type
@@ -106,8 +216,40 @@ void merge_parts(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdi
  */
 template<typename T, typename Compare>
 void parallel_merge_parts(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp) {
-    // Parallel merge disabled for Work Stealing V3 compatibility
-    merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    std::ptrdiff_t n1 = hi1 - lo1;
+    std::ptrdiff_t n2 = hi2 - lo2;
+    std::ptrdiff_t size = n1 + n2;
+
+    auto overlaps = [&](const T* src, std::ptrdiff_t lo, std::ptrdiff_t hi) {
+        std::less<const T*> before;
+        return lo < hi && before(src + lo, dst + k + size) && before(dst + k, src + hi);
+    };
+    if (size < 2 * MIN_PARALLEL_MERGE_CHUNK || overlaps(a1, lo1, hi1) || overlaps(a2, lo2, hi2)) {
+        merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+        return;
+    }
+    auto& pool = getThreadPool();
+    std::ptrdiff_t threads = std::min(concurrency_budget(pool), size / MIN_PARALLEL_MERGE_CHUNK);
+    if (threads < 2) {
+        merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+        return;
+    }
+
+    int chunks = static_cast<int>(threads);
+    std::vector<std::ptrdiff_t> splits(chunks + 1);
+    splits[0] = 0;
+    splits[chunks] = n1;
+    parallel_for_chunks(pool, chunks - 1, [&](int i) {
+        splits[i + 1] = merge_path_split(size * (i + 1) / chunks, a1, lo1, n1, a2, lo2, n2, comp);
+    });
+
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        std::ptrdiff_t from = size * i / chunks;
+        std::ptrdiff_t to = size * (i + 1) / chunks;
+        std::ptrdiff_t from1 = splits[i];
+        std::ptrdiff_t to1 = splits[i + 1];
+        merge_parts(dst, k + from, a1, lo1 + from1, lo1 + to1, a2, lo2 + (from - from1), lo2 + (to - to1), comp);
+    });
 }
 
 } // namespace dual_pivot
@@ -3,69 +3,290 @@
 
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <new>
+#include <type_traits>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "dpqs/constants.hpp"
+#include "dpqs/scratch_memory.hpp"
+#include "dpqs/parallel/threadpool.hpp"
 
 namespace dual_pivot {
 
-template<typename T, typename Allocator = std::allocator<T>>
-class BufferManager {
+/**
+ * @brief Per-thread pool of scratch blocks, the default scratch resource.
+ *
+ * Requests are rounded up to size classes (four per power of two, at least
+ * MIN_SCRATCH_BLOCK_BYTES) and served with blocks aligned to SCRATCH_ALIGNMENT
+ * bytes, or to HUGE_PAGE_SIZE from one huge page up. Freed blocks stay in a
+ * cache of the freeing thread (at most MAX_CACHED_SCRATCH_BLOCKS blocks and
+ * MAX_CACHED_SCRATCH_BYTES bytes, oldest evicted first) and serve the next
+ * request of their class, so repeated sorts reuse pages that are already
+ * mapped instead of faulting in fresh ones. A thread's cache is freed when the
+ * thread exits or calls trim().
+ *
+ * There is one BufferManager object; the caches behind it are per thread, so
+ * a block may be freed on another thread than the one that allocated it.
+ */
+class BufferManager : public std::pmr::memory_resource {
+public:
+    static BufferManager& instance() {
+        static BufferManager pool;
+        return pool;
+    }
+
+    /// Size of the block serving a request of 'bytes'
+    static std::size_t block_size(std::size_t bytes) {
+        if (bytes <= MIN_SCRATCH_BLOCK_BYTES) return MIN_SCRATCH_BLOCK_BYTES;
+        if (bytes > (std::numeric_limits<std::size_t>::max() >> 2)) throw std::bad_alloc();
+        std::size_t power = MIN_SCRATCH_BLOCK_BYTES;
+        while (power * 2 < bytes) power *= 2;
+        std::size_t step = power / 4;
+        return (bytes + step - 1) / step * step;
+    }
+
+    /**
+     * @brief Backs blocks of at least HUGE_PAGE_SIZE with transparent huge pages (Linux).
+     *
+     * Off by default; applies to blocks allocated afterwards.
+     */
+    static void set_huge_pages(bool enabled) {
+        huge_pages_flag().store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool huge_pages() {
+        return huge_pages_flag().load(std::memory_order_relaxed);
+    }
+
+    /// Bytes cached by the calling thread
+    static std::size_t cached_bytes() {
+        return cache().bytes;
+    }
+
+    /// Blocks the calling thread had to allocate because its cache had none of the class
+    static std::size_t fresh_blocks() {
+        return cache().fresh;
+    }
+
+    /// Frees the blocks cached by the calling thread
+    static void trim() {
+        cache().clear();
+    }
+
 private:
-    static thread_local std::vector<T, Allocator> buffer_pool;
-    static thread_local bool pool_initialized;
-    static thread_local std::vector<int> buffer_offsets;
-    static thread_local int buffer_usage_count;
+    struct Block {
+        void* ptr;
+        std::size_t size;
+        std::size_t alignment;
+    };
 
-public:
-    static T* getBuffer(int size, int& offset) {
-        if (!pool_initialized || buffer_pool.size() < size) {
-            int new_size = std::max(size, static_cast<int>(buffer_pool.size() * 1.5));
-            buffer_pool.resize(new_size);
-            buffer_offsets.resize(new_size / 64 + 1, 0);
-            pool_initialized = true;
-            offset = 0;
-            buffer_usage_count = 0;
-            return buffer_pool.data();
+    struct ThreadCache {
+        std::vector<Block> blocks; // Oldest first
+        std::size_t bytes = 0;
+        std::size_t fresh = 0;
+
+        void evict_oldest() {
+            release(blocks.front());
+            bytes -= blocks.front().size;
+            blocks.erase(blocks.begin());
+        }
+
+        void clear() {
+            while (!blocks.empty()) evict_oldest();
         }
 
-        offset = (buffer_usage_count * 32) % (buffer_pool.size() / 2);
-        buffer_usage_count++;
+        ~ThreadCache() {
+            clear();
+        }
+    };
+
+    BufferManager() = default;
+
+    static ThreadCache& cache() {
+        thread_local ThreadCache local;
+        return local;
+    }
+
+    static std::atomic<bool>& huge_pages_flag() {
+        static std::atomic<bool> flag{false};
+        return flag;
+    }
 
-        return buffer_pool.data();
+    static std::size_t block_alignment(std::size_t size, std::size_t alignment) {
+        return std::max({SCRATCH_ALIGNMENT, alignment, size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : std::size_t(1)});
     }
 
-    static void returnBuffer(T* buffer, int size, int offset) {
-        if (buffer >= buffer_pool.data() &&
-            buffer < buffer_pool.data() + buffer_pool.size()) {
-            int chunk_index = offset / 64;
-            if (chunk_index < buffer_offsets.size()) {
-                buffer_offsets[chunk_index] = 0;
+    static void release(const Block& block) {
+        ::operator delete(block.ptr, std::align_val_t(block.alignment));
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::size_t size = block_size(bytes);
+        std::size_t align = block_alignment(size, alignment);
+        ThreadCache& local = cache();
+        // Most recently freed first: its pages are the most likely to be in cache
+        for (std::size_t i = local.blocks.size(); i-- > 0; ) {
+            if (local.blocks[i].size == size && local.blocks[i].alignment == align) {
+                void* p = local.blocks[i].ptr;
+                local.bytes -= size;
+                local.blocks.erase(local.blocks.begin() + static_cast<std::ptrdiff_t>(i));
+                return p;
             }
         }
-    }
 
-    static int getBufferUsage() {
-        return buffer_usage_count;
+        ++local.fresh;
+        void* p = ::operator new(size, std::align_val_t(align));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (size >= HUGE_PAGE_SIZE && huge_pages()) {
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+#endif
+        return p;
     }
 
-    static void optimizePool() {
-        if (buffer_usage_count > 100) {
-            buffer_usage_count = 0;
-            std::fill(buffer_offsets.begin(), buffer_offsets.end(), 0);
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::size_t size = block_size(bytes);
+        Block block{p, size, block_alignment(size, alignment)};
+        if (size > MAX_CACHED_SCRATCH_BYTES) {
+            release(block);
+            return;
         }
+        ThreadCache& local = cache();
+        if (local.blocks.capacity() == 0) local.blocks.reserve(MAX_CACHED_SCRATCH_BLOCKS);
+        while (!local.blocks.empty() &&
+               (local.blocks.size() == MAX_CACHED_SCRATCH_BLOCKS || local.bytes + size > MAX_CACHED_SCRATCH_BYTES)) {
+            local.evict_oldest();
+        }
+        local.blocks.push_back(block);
+        local.bytes += size;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
     }
 };
 
-template<typename T, typename Allocator>
-thread_local std::vector<T, Allocator> BufferManager<T, Allocator>::buffer_pool;
+/**
+ * @brief Memory resource the scratch memory of sorts on the calling thread comes from.
+ *
+ * The resource of the innermost ScratchResourceScope on this thread, or the
+ * per-thread scratch pool (BufferManager) outside of one. Scratch memory is the
+ * merge buffer and run array of the run merger, the radix and samplesort
+ * buffers, and the element copies of the non-contiguous iterator overloads.
+ * Tasks that parallel sorts run on pool workers use their own thread's pool.
+ */
+inline std::pmr::memory_resource* scratch_resource() {
+    std::pmr::memory_resource* resource = scratch_resource_slot();
+    return resource != nullptr ? resource : &BufferManager::instance();
+}
+
+/**
+ * @brief Scratch array for the merge paths with NUMA-friendly page placement.
+ *
+ * std::vector<T>(n) value-initializes the whole buffer on the allocating thread,
+ * so every page ends up on that thread's NUMA node. For trivial T this buffer
+ * leaves the memory uninitialized instead (the merges write before they read);
+ * a parallel buffer of at least MIN_FIRST_TOUCH_BYTES is then first touched by
+ * the shared pool in one chunk per thread of the sort's concurrency budget,
+ * spreading its pages over the nodes the sort runs on. Other types are
+ * value-initialized like std::vector.
+ * The memory comes from scratch_resource() of the constructing thread.
+ */
+template<typename T>
+class ScratchBuffer {
+private:
+    static constexpr bool trivial = std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>;
 
-template<typename T, typename Allocator>
-thread_local bool BufferManager<T, Allocator>::pool_initialized = false;
+    T* ptr = nullptr;
+    std::size_t count = 0;
+    std::pmr::memory_resource* resource = nullptr;
 
-template<typename T, typename Allocator>
-thread_local std::vector<int> BufferManager<T, Allocator>::buffer_offsets;
+    static void touch_pages(unsigned char* bytes, std::size_t length) {
+        for (std::size_t i = 0; i < length; i += FIRST_TOUCH_PAGE_SIZE) {
+            bytes[i] = 0;
+        }
+    }
 
-template<typename T, typename Allocator>
-thread_local int BufferManager<T, Allocator>::buffer_usage_count = 0;
+    // Allocates the buffer; the public constructors delegate here, so the
+    // destructor releases it if the first touch throws
+    ScratchBuffer(std::size_t size, std::nullptr_t) : count(size) {
+        if (size == 0) return;
+        resource = scratch_resource();
+        ptr = static_cast<T*>(resource->allocate(size * sizeof(T), alignof(T)));
+        if constexpr (!trivial) {
+            try {
+                std::uninitialized_value_construct_n(ptr, size);
+            } catch (...) {
+                resource->deallocate(ptr, size * sizeof(T), alignof(T));
+                throw;
+            }
+        }
+    }
+
+    bool first_touch_wanted() const {
+        return trivial && count * sizeof(T) >= MIN_FIRST_TOUCH_BYTES;
+    }
+
+    // Touches the pages as tasks of 'group', one chunk per thread of its budget
+    void first_touch_parallel(TaskGroup& group) {
+        auto& pool = getThreadPool();
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(ptr);
+        std::size_t length = count * sizeof(T);
+        std::size_t chunks = static_cast<std::size_t>(concurrency_budget(pool, group));
+        // Chunks are whole pages, so workers rarely touch the same page
+        std::size_t chunk = (length / chunks + FIRST_TOUCH_PAGE_SIZE - 1) / FIRST_TOUCH_PAGE_SIZE * FIRST_TOUCH_PAGE_SIZE;
+
+        for (std::size_t begin = 0; begin < length; begin += chunk) {
+            std::size_t size = std::min(chunk, length - begin);
+            pool.submit(group, [bytes, begin, size] { touch_pages(bytes + begin, size); });
+        }
+        pool.wait(group);
+    }
+
+public:
+    /**
+     * @param size Number of elements
+     * @param parallel Whether a parallel sort will use the buffer (enables first
+     *        touch by the pool, within the budget of the running task's group)
+     */
+    explicit ScratchBuffer(std::size_t size, bool parallel = false) : ScratchBuffer(size, nullptr) {
+        if (parallel && first_touch_wanted()) {
+            TaskGroup group(TaskGroup::inherit_budget);
+            first_touch_parallel(group);
+        }
+    }
+
+    /**
+     * @brief Buffer of a parallel sort, allocated outside the pool before the sort starts.
+     *
+     * The first touch runs as tasks of 'group', the sort's own group, so it
+     * stays within the sort's budget. 'group' must have no unfinished tasks.
+     */
+    ScratchBuffer(std::size_t size, TaskGroup& group) : ScratchBuffer(size, nullptr) {
+        if (first_touch_wanted()) {
+            first_touch_parallel(group);
+        }
+    }
+
+    ~ScratchBuffer() {
+        if (ptr == nullptr) return;
+        if constexpr (!trivial) {
+            std::destroy_n(ptr, count);
+        }
+        resource->deallocate(ptr, count * sizeof(T), alignof(T));
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    T* data() { return ptr; }
+    std::size_t size() const { return count; }
+};
 
 } // namespace dual_pivot
 
@@ -1,142 +1,215 @@
 #ifndef DPQS_PARALLEL_COMPLETER_HPP
 #define DPQS_PARALLEL_COMPLETER_HPP
 
-#include "dpqs/utils.hpp"
+#include "dpqs/constants.hpp"
 #include "dpqs/parallel/threadpool.hpp"
+#include "dpqs/parallel/buffer_manager.hpp"
 #include <atomic>
 #include <mutex>
-#include <exception>
-#include <thread>
-#include <chrono>
+#include <new>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 
 namespace dual_pivot {
 
-template<typename T>
-class CountedCompleter {
-protected:
-    std::atomic<int> pending{0};
-    CountedCompleter* parent{nullptr};
-    bool completed{false};
-    std::mutex completion_mutex;  // Enhanced thread safety
-    std::condition_variable completion_cv; // For waiting on completion
-
+/**
+ * @brief Bump allocator for the nodes of one task tree.
+ *
+ * Nodes are carved from chunks of the scratch pool: taking one is a fetch_add
+ * on the current chunk, and only the thread that finds the chunk full takes
+ * the lock to install the next one (twice as large). Nothing is freed before
+ * the arena is destroyed, after its tree has completed, so nodes must be
+ * trivially destructible. Thread-safe.
+ */
+class NodeArena {
 public:
-    CountedCompleter(CountedCompleter* parent = nullptr) : parent(parent) {
-        if (parent) {
-            parent->pending.fetch_add(1);
+    /// @param first_chunk Bytes of the first chunk
+    explicit NodeArena(std::size_t first_chunk = NODE_ARENA_CHUNK_BYTES) : next_capacity(first_chunk) {}
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    ~NodeArena() {
+        Chunk* chunk = current.load(std::memory_order_relaxed);
+        while (chunk != nullptr) {
+            Chunk* previous = chunk->previous;
+            BufferManager::instance().deallocate(chunk, HEADER + chunk->capacity, NODE_ALIGNMENT);
+            chunk = previous;
         }
     }
 
-    virtual ~CountedCompleter() = default;
+    /// Constructs a node in the arena
+    template<typename Node, typename... Args>
+    Node* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<Node>, "Arena nodes are never destroyed");
+        static_assert(alignof(Node) <= NODE_ALIGNMENT, "Arena nodes are aligned to max_align_t");
+        return ::new (allocate(sizeof(Node))) Node(std::forward<Args>(args)...);
+    }
 
-    virtual void compute() = 0;
-    virtual void onCompletion(CountedCompleter* caller) {}
-    virtual void onExceptionalCompletion(std::exception_ptr ex, CountedCompleter* caller) {}
-
-    void invoke() {
-        try {
-            compute();
-            tryComplete();
-        } catch (...) {
-            completeExceptionally(std::current_exception());
+    /// Number of chunks taken from the scratch pool so far
+    std::size_t chunk_count() const {
+        std::lock_guard<std::mutex> lock(grow_mutex);
+        return chunks;
+    }
+
+private:
+    static constexpr std::size_t NODE_ALIGNMENT = alignof(std::max_align_t);
+
+    struct Chunk {
+        Chunk* previous;
+        std::size_t capacity;
+        std::atomic<std::size_t> used;
+    };
+
+    // Node memory starts after the chunk header
+    static constexpr std::size_t HEADER = (sizeof(Chunk) + NODE_ALIGNMENT - 1) / NODE_ALIGNMENT * NODE_ALIGNMENT;
+
+    void* allocate(std::size_t bytes) {
+        bytes = (bytes + NODE_ALIGNMENT - 1) / NODE_ALIGNMENT * NODE_ALIGNMENT;
+        Chunk* chunk = current.load(std::memory_order_acquire);
+        while (true) {
+            if (chunk != nullptr) {
+                std::size_t offset = chunk->used.fetch_add(bytes, std::memory_order_relaxed);
+                if (offset + bytes <= chunk->capacity) {
+                    return reinterpret_cast<unsigned char*>(chunk) + HEADER + offset;
+                }
+            }
+            chunk = grow(chunk, bytes);
         }
     }
 
-    void wait() {
-        std::unique_lock<std::mutex> lock(completion_mutex);
-        completion_cv.wait(lock, [this]{ return completed; });
+    // Installs a new chunk unless another thread already replaced 'full'
+    Chunk* grow(Chunk* full, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(grow_mutex);
+        Chunk* chunk = current.load(std::memory_order_relaxed);
+        if (chunk != full) {
+            return chunk;
+        }
+        std::size_t capacity = std::max(next_capacity, bytes);
+        next_capacity = capacity * 2;
+        void* memory = BufferManager::instance().allocate(HEADER + capacity, NODE_ALIGNMENT);
+        chunk = ::new (memory) Chunk{full, capacity, {0}};
+        ++chunks;
+        current.store(chunk, std::memory_order_release);
+        return chunk;
     }
 
+    std::atomic<Chunk*> current{nullptr};
+    std::size_t next_capacity;
+    std::size_t chunks = 0;
+    mutable std::mutex grow_mutex;
+};
+
+/**
+ * @brief State shared by all nodes of one task tree: the comparator and the node arena.
+ *
+ * Nodes keep a pointer to it instead of a copy of the comparator, so they stay
+ * small and trivially destructible whatever the comparator holds.
+ */
+template<typename Compare>
+struct TaskTree {
+    explicit TaskTree(Compare comp) : comp(comp) {}
+
+    Compare comp;
+    NodeArena nodes;
+};
+
+/**
+ * @brief Node of a fork/join task tree completed without blocking (Java's CountedCompleter).
+ *
+ * A node's pending count is the number of children it has forked and that
+ * have not completed yet. compute() forks children (addToPendingCount or
+ * setPendingCount first) and ends with tryComplete(). tryComplete() decrements
+ * the pending count, or, when it is already 0, completes the node: it runs
+ * onCompletion() and moves on to the parent. So a node completes on the thread
+ * of whichever of its children finishes last, and no thread ever waits on a
+ * node. The count is a lock-free CAS loop; its acquire/release order makes the
+ * children's results visible to onCompletion().
+ *
+ * Forked nodes are pool tasks of the group of the forking task, so a tree
+ * whose root was submitted to a TaskGroup has completed once the group is done.
+ * An exception thrown by compute() or onCompletion() fails that group: the
+ * tree stops where it is and the waiting caller (invoke()) rethrows it.
+ * Nodes live in the NodeArena of their tree and are never destroyed one by one.
+ *
+ * @tparam T Element type of the tree (void for type-independent trees)
+ */
+template<typename T>
+class CountedCompleter {
+public:
+    explicit CountedCompleter(CountedCompleter* parent = nullptr) : parent(parent) {}
+
+    CountedCompleter(const CountedCompleter&) = delete;
+    CountedCompleter& operator=(const CountedCompleter&) = delete;
+
+    /// The work of the node; forks its children and ends with tryComplete()
+    virtual void compute() = 0;
+
+    /// Runs once the node and all its children are done; 'caller' is the node that completed it
+    virtual void onCompletion(CountedCompleter* /*caller*/) {}
+
+    /// Runs compute() as a task of the group of the calling task
     void fork() {
-        auto& pool = getThreadPool();
-        pool.submit([this]() { invoke(); });
+        getThreadPool().submit([this] { compute(); });
+    }
+
+    /**
+     * @brief Runs the tree rooted at this node on 'pool' and returns once it has completed.
+     *
+     * The root is submitted to 'group' and the caller helps with the group
+     * until it is done.
+     */
+    void invoke(ThreadPool& pool, TaskGroup& group) {
+        pool.submit(group, [this] { compute(); });
+        pool.wait(group);
     }
 
-    // Enhanced completion with proper propagation (matching Java's sophistication)
+    /// Counts one arrival: completes this node (and its ancestors) if nothing else is pending
     void tryComplete() {
-        CountedCompleter* curr = this;
-        while (curr != nullptr) {
-            std::lock_guard<std::mutex> lock(curr->completion_mutex);
-
-            if (curr->pending.load() == 0 && !curr->completed) {
-                curr->completed = true;
-                curr->completion_cv.notify_all(); // Notify waiters
-
-                try {
-                    curr->onCompletion(curr);
-                } catch (...) {
-                    curr->completeExceptionally(std::current_exception());
+        CountedCompleter* node = this;
+        CountedCompleter* caller = this;
+        while (true) {
+            int count = node->pending.load(std::memory_order_acquire);
+            if (count == 0) {
+                node->onCompletion(caller);
+                caller = node;
+                node = node->parent;
+                if (node == nullptr) {
                     return;
                 }
-
-                CountedCompleter* parent = curr->parent;
-
-                if (parent) {
-                    // Advanced pending count management with atomic operations
-                    int prevPending = parent->pending.fetch_sub(1);
-                    if (prevPending == 1) {
-                        curr = parent;
-                        continue;  // Propagate completion to parent
-                    }
-                }
-                break;
-            } else {
-                break;
-            }
-        }
-    }
-
-    // Enhanced exception handling (matching Java's pattern)
-    void completeExceptionally(std::exception_ptr ex) {
-        std::lock_guard<std::mutex> lock(completion_mutex);
-        completed = true;
-
-        // Propagate exception to parent chain
-        CountedCompleter* curr = parent;
-        while (curr != nullptr) {
-            try {
-                curr->onExceptionalCompletion(ex, this);
-                curr = curr->parent;
-            } catch (...) {
-                // Swallow additional exceptions during propagation
-                break;
+            } else if (node->pending.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel,
+                                                           std::memory_order_relaxed)) {
+                return;
             }
         }
     }
 
     void addToPendingCount(int delta) {
-        pending.fetch_add(delta);
+        pending.fetch_add(delta, std::memory_order_relaxed);
     }
 
-    // Java-style pending count management
     void setPendingCount(int count) {
-        pending.store(count);
+        pending.store(count, std::memory_order_relaxed);
     }
 
     int getPendingCount() const {
-        return pending.load();
+        return pending.load(std::memory_order_acquire);
     }
 
-    bool isCompletedAbnormally() const {
-        return completed && pending.load() < 0;  // Use negative pending as error flag
+    /// Parent of the node (nullptr for the root)
+    CountedCompleter* getCompleter() const {
+        return parent;
     }
 
-    // Advanced completion checking with timeout (C++ enhancement)
-    bool tryCompleteWithTimeout(int timeout_ms) {
-        auto start = std::chrono::steady_clock::now();
-
-        while (!completed) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
-
-            if (elapsed.count() > timeout_ms) {
-                return false;  // Timeout
-            }
+protected:
+    // Nodes are never deleted through a base pointer: they live in a NodeArena
+    ~CountedCompleter() = default;
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-        return true;
-    }
+private:
+    std::atomic<int> pending{0};
+    CountedCompleter* parent;
 };
 
 }
@@ -9,6 +9,12 @@
 
 namespace dual_pivot {
 
+// Defined in run_merger.hpp
+template<typename T, typename Compare>
+T* merge_runs(T* a, T* b, std::ptrdiff_t offset, int aim,
+             const std::ptrdiff_t* run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp,
+             bool parallel = false);
+
 class GenericMerger : public CountedCompleter<void> {
 private:
     ArrayPointer dst;
@@ -103,96 +109,128 @@ public:
      * - Use parallel subdivision for large segments
      * - Fall back to sequential merge for small segments
      * - Maintain cache locality through careful work distribution
+     * - Stopped sort (SortStop): only move both segments to the destination
      */
     void compute() override {
-        // Use parallel merge with subdivision for large parts
-        if (hi1 - lo1 >= MIN_PARALLEL_MERGE_PARTS_SIZE && hi2 - lo2 >= MIN_PARALLEL_MERGE_PARTS_SIZE) {
+        if (sort_stop_requested()) {
+            merge_tail(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+        } else if (hi1 - lo1 >= MIN_PARALLEL_MERGE_PARTS_SIZE && hi2 - lo2 >= MIN_PARALLEL_MERGE_PARTS_SIZE) {
+            // Use parallel merge with subdivision for large parts
             // Parallel merge with binary search partitioning
             parallel_merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
         } else {
             // Sequential merge for small parts
             merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
         }
+        this->tryComplete();
     }
 };
 
-// RunMerger class for parallel run merging (matching Java's RunMerger extends RecursiveTask)
+/**
+ * @brief State shared by all nodes of one RunMerger tree.
+ *
+ * The run indices belong to the caller and are only read, so every node sees
+ * the same array instead of a copy.
+ */
 template<typename T, typename Compare>
-class RunMerger : public CountedCompleter<void> {
-public:
-    T* result = nullptr;
+struct RunMergeTree : TaskTree<Compare> {
+    RunMergeTree(T* a, T* b, std::ptrdiff_t offset, const std::ptrdiff_t* run, Compare comp)
+        : TaskTree<Compare>(comp), a(a), b(b), offset(offset), run(run) {}
 
-private:
     T* a;
     T* b;
     std::ptrdiff_t offset;
-    int aim;
-    std::vector<std::ptrdiff_t> run;
-    std::ptrdiff_t lo, hi;
-    std::ptrdiff_t mi; // Store split point
-    Compare comp;
-
-    RunMerger* leftChild = nullptr;
-    RunMerger* rightChild = nullptr;
+    const std::ptrdiff_t* run;
+};
 
+/**
+ * @brief Fork/join node merging runs lo..hi of a RunMergeTree (Java's RunMerger).
+ *
+ * A node whose runs span fewer than 2 * MIN_PARALLEL_MERGE_CHUNK elements
+ * merges them with merge_runs on its own thread. Larger ones fork their left
+ * half, compute the right one and merge both in onCompletion, on the thread
+ * that finishes last, splitting that merge across threads with the merge path.
+ */
+template<typename T, typename Compare>
+class RunMerger : public CountedCompleter<void> {
 public:
-    RunMerger(CountedCompleter<void>* parent, T* a, T* b, std::ptrdiff_t offset, int aim, const std::vector<std::ptrdiff_t>& run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp)
-        : CountedCompleter<void>(parent), a(a), b(b), offset(offset), aim(aim), run(run), lo(lo), hi(hi), comp(comp) {}
+    T* result = nullptr; ///< Array holding the merged runs once the node has completed
 
-    ~RunMerger() {
-        if (leftChild) delete leftChild;
-        if (rightChild) delete rightChild;
+    RunMerger(RunMerger* parent, RunMergeTree<T, Compare>* tree, int aim, std::ptrdiff_t lo, std::ptrdiff_t hi)
+        : CountedCompleter<void>(parent), tree(tree), aim(aim), lo(lo), hi(hi) {}
+
+    /**
+     * @brief merge_runs on the pool: merges runs lo..hi of a through b and returns the array holding them.
+     *
+     * The tree runs as a task group of its own, so this may be called inside a
+     * pool task; that group counts against the budget of the calling task's group.
+     */
+    static T* merge(T* a, T* b, std::ptrdiff_t offset, int aim,
+                    const std::ptrdiff_t* run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp) {
+        RunMergeTree<T, Compare> tree(a, b, offset, run, comp);
+        auto* root = tree.nodes.template create<RunMerger>(nullptr, &tree, aim, lo, hi);
+        TaskGroup group(TaskGroup::inherit_budget);
+        root->invoke(getThreadPool(), group);
+        return root->result;
     }
 
     void compute() override {
-        if (hi - lo == 1) {
-            // Base case: single run
-            if (aim >= 0) {
-                result = a;
-            } else {
-                // Copy elements in reverse order (matching Java's approach)
-                for (std::ptrdiff_t i = run[hi], j = i - offset, low = run[lo]; i > low; ) {
-                    b[--j] = a[--i];
-                }
-                result = b;
-            }
+        const std::ptrdiff_t* run = tree->run;
+        if (hi - lo == 1 || run[hi] - run[lo] < 2 * MIN_PARALLEL_MERGE_CHUNK || sort_stop_requested()) {
+            result = merge_runs(tree->a, tree->b, tree->offset, aim, run, lo, hi, tree->comp, true);
             tryComplete();
             return;
         }
 
-        // Advanced parallel subdivision (matching Java's sophisticated approach)
+        // Split into approximately equal parts
         mi = lo;
-        std::ptrdiff_t rmi = (run[lo] + run[hi]) >> 1; // Unsigned right shift equivalent
+        std::ptrdiff_t rmi = (run[lo] + run[hi]) >> 1;
         while (run[++mi + 1] <= rmi);
 
-        // Create parallel tasks for left and right parts
-        leftChild = new RunMerger(this, a, b, offset, -aim, run, lo, mi, comp);
-        rightChild = new RunMerger(this, a, b, offset, 0, run, mi, hi, comp);
-
-        leftChild->fork();
-        rightChild->fork();
+        // Two children and this task's own arrival
+        setPendingCount(2);
+        left = tree->nodes.template create<RunMerger>(this, tree, -aim, lo, mi);
+        right = tree->nodes.template create<RunMerger>(this, tree, 0, mi, hi);
+        left->fork();
+        right->compute();
+        tryComplete();
     }
 
-    void onCompletion(CountedCompleter<void>* caller) override {
-        if (leftChild && rightChild) {
-            T* a1 = leftChild->result;
-            T* a2 = rightChild->result;
-
-            // Advanced destination calculation (matching Java's sophisticated logic)
-            T* dst = (a1 == a) ? b : a;
-
-            // Complex offset calculations (matching Java's approach)
-            std::ptrdiff_t k   = (a1 == a) ? run[lo] - offset : run[lo];
-            std::ptrdiff_t lo1 = (a1 == b) ? run[lo] - offset : run[lo];
-            std::ptrdiff_t hi1 = (a1 == b) ? run[mi] - offset : run[mi];
-            std::ptrdiff_t lo2 = (a2 == b) ? run[mi] - offset : run[mi];
-            std::ptrdiff_t hi2 = (a2 == b) ? run[hi] - offset : run[hi];
-
-            // Advanced merge with parallel coordination
-            merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
-            result = dst;
+    void onCompletion(CountedCompleter<void>* /*caller*/) override {
+        if (left == nullptr) {
+            return;
+        }
+        T* a = tree->a;
+        T* b = tree->b;
+        std::ptrdiff_t offset = tree->offset;
+        const std::ptrdiff_t* run = tree->run;
+        T* a1 = left->result;
+        T* a2 = right->result;
+
+        T* dst = (a1 == a) ? b : a;
+
+        std::ptrdiff_t k   = (a1 == a) ? run[lo] - offset : run[lo];
+        std::ptrdiff_t lo1 = (a1 == b) ? run[lo] - offset : run[lo];
+        std::ptrdiff_t hi1 = (a1 == b) ? run[mi] - offset : run[mi];
+        std::ptrdiff_t lo2 = (a2 == b) ? run[mi] - offset : run[mi];
+        std::ptrdiff_t hi2 = (a2 == b) ? run[hi] - offset : run[hi];
+
+        // The last merges are few and large: split each across threads
+        if (sort_stop_requested()) {
+            merge_tail(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+        } else {
+            parallel_merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, tree->comp);
         }
+        result = dst;
     }
+
+private:
+    RunMergeTree<T, Compare>* tree;
+    int aim;
+    std::ptrdiff_t lo, hi;
+    std::ptrdiff_t mi = 0;
+    RunMerger* left = nullptr;
+    RunMerger* right = nullptr;
 };
 
 }
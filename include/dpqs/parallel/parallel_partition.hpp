@@ -0,0 +1,185 @@
+#ifndef DPQS_PARALLEL_PARALLEL_PARTITION_HPP
+#define DPQS_PARALLEL_PARALLEL_PARTITION_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "dpqs/constants.hpp"
+#include "dpqs/partition.hpp"
+#include "dpqs/parallel/threadpool.hpp"
+
+namespace dual_pivot {
+
+/**
+ * @brief Runs body(0) .. body(count - 1) on the pool and the calling thread.
+ *
+ * The calling thread runs body(0) itself and then helps with the rest, so the
+ * call also completes when every worker is busy elsewhere. Called inside a
+ * task, the chunks count against the budget of that task's group. If a chunk
+ * throws, the chunks not started yet are dropped and the first exception is
+ * rethrown once the others have finished.
+ */
+template<typename Body>
+void parallel_for_chunks(ThreadPool& pool, int count, const Body& body) {
+    TaskGroup group(TaskGroup::inherit_budget);
+    try {
+        for (int i = 1; i < count; ++i) {
+            pool.submit(group, [&body, i] { body(i); });
+        }
+        body(0);
+    } catch (...) {
+        // The submitted chunks still reference 'body': rethrown by wait() below
+        group.capture_exception(std::current_exception());
+    }
+    pool.wait(group);
+}
+
+/**
+ * @brief Parallel in-place two-way partition (blocked, Frias/Petit style).
+ *
+ * 1. The range is cut into 'chunks' contiguous chunks and each chunk is
+ *    partitioned locally with partition_block_pass.
+ * 2. The global split m is the start plus the sum of the matching counts. The
+ *    non-matching elements left of m and the matching elements right of m are
+ *    equally many; both lists are a few intervals (at most one per chunk).
+ * 3. The k-th misplaced element of one list is swapped with the k-th of the
+ *    other, the swaps again split evenly between the chunks.
+ *
+ * @return Index of the first element that does not match
+ */
+template<bool LessThanPivot, typename Classifier, typename T, typename Compare>
+std::ptrdiff_t parallel_partition_pass(T* a, std::ptrdiff_t low, std::ptrdiff_t high, const T& pivot, Compare comp,
+                                       ThreadPool& pool, int chunks) {
+    std::ptrdiff_t size = high - low;
+    std::vector<std::ptrdiff_t> bounds(chunks + 1);
+    std::vector<std::ptrdiff_t> splits(chunks);
+    for (int i = 0; i <= chunks; ++i) {
+        bounds[i] = low + size * i / chunks;
+    }
+
+    // Phase 1: local partitions
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        splits[i] = partition_block_pass<LessThanPivot, Classifier>(a, bounds[i], bounds[i + 1], pivot, comp);
+    });
+
+    std::ptrdiff_t middle = low;
+    for (int i = 0; i < chunks; ++i) {
+        middle += splits[i] - bounds[i];
+    }
+
+    // Phase 2: misplaced intervals on both sides of the global split
+    struct Interval { std::ptrdiff_t begin, end; };
+    std::vector<Interval> left, right;
+    for (int i = 0; i < chunks; ++i) {
+        if (splits[i] < middle) {
+            std::ptrdiff_t end = std::min(bounds[i + 1], middle);
+            if (splits[i] < end) left.push_back({splits[i], end});
+        }
+        std::ptrdiff_t begin = std::max(bounds[i], middle);
+        if (begin < splits[i]) right.push_back({begin, splits[i]});
+    }
+
+    std::vector<std::ptrdiff_t> left_prefix(left.size() + 1, 0), right_prefix(right.size() + 1, 0);
+    for (std::size_t j = 0; j < left.size(); ++j) left_prefix[j + 1] = left_prefix[j] + (left[j].end - left[j].begin);
+    for (std::size_t j = 0; j < right.size(); ++j) right_prefix[j + 1] = right_prefix[j] + (right[j].end - right[j].begin);
+    std::ptrdiff_t misplaced = left_prefix.back();
+    if (misplaced == 0) return middle;
+
+    // Phase 3: swap the k-th misplaced element of both lists
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        std::ptrdiff_t from = misplaced * i / chunks;
+        std::ptrdiff_t to = misplaced * (i + 1) / chunks;
+        if (from == to) return;
+        std::size_t l = std::upper_bound(left_prefix.begin(), left_prefix.end(), from) - left_prefix.begin() - 1;
+        std::size_t r = std::upper_bound(right_prefix.begin(), right_prefix.end(), from) - right_prefix.begin() - 1;
+        std::ptrdiff_t x = left[l].begin + (from - left_prefix[l]);
+        std::ptrdiff_t y = right[r].begin + (from - right_prefix[r]);
+        for (std::ptrdiff_t k = from; k < to; ++k) {
+            if (x == left[l].end) x = left[++l].begin;
+            if (y == right[r].end) y = right[++r].begin;
+            std::swap(a[x++], a[y++]);
+        }
+    });
+    return middle;
+}
+
+/**
+ * @brief Parallel version of partition_dual_pivot with the same result layout.
+ *
+ * Two parallel passes over the inner range: the elements not greater than P2
+ * are moved to the front, then the elements less than P1 to the front of those.
+ * The passes use the block kernel, so types that partition_dual_pivot_auto
+ * keeps on the classic scheme are partitioned sequentially with it.
+ *
+ * @param chunks Number of threads that may work on the partition (at least 2)
+ */
+template<typename T, typename Compare>
+std::pair<std::ptrdiff_t, std::ptrdiff_t> parallel_partition_dual_pivot(T* a, std::ptrdiff_t low, std::ptrdiff_t high, std::ptrdiff_t pivotIndex1, std::ptrdiff_t pivotIndex2, Compare comp, ThreadPool& pool, int chunks) {
+    if constexpr (use_simd_partition_v<T, Compare> || use_block_partition_v<T, Compare>) {
+        // Move pivots to ends
+        std::swap(a[low], a[pivotIndex1]);
+        std::swap(a[high - 1], a[pivotIndex2]);
+
+        const T pivot1 = a[low];
+        const T pivot2 = a[high - 1];
+
+        return with_block_classifier<T, Compare>([&](auto classifier) {
+            using Classifier = decltype(classifier);
+            std::ptrdiff_t gt = parallel_partition_pass<false, Classifier>(a, low + 1, high - 1, pivot2, comp, pool, chunks);
+            std::ptrdiff_t lt = parallel_partition_pass<true, Classifier>(a, low + 1, gt, pivot1, comp, pool, chunks);
+
+            --lt;
+            std::swap(a[low], a[lt]);
+            std::swap(a[high - 1], a[gt]);
+            return std::make_pair(lt, gt);
+        });
+    } else {
+        (void)pool;
+        (void)chunks;
+        return partition_dual_pivot(a, low, high, pivotIndex1, pivotIndex2, comp);
+    }
+}
+
+/**
+ * @brief Parallel version of partition_single_pivot with the same result layout.
+ *
+ * Like parallel_partition_dual_pivot, only types with a block kernel are
+ * partitioned in parallel; the others use partition_single_pivot.
+ *
+ * @return Inclusive bounds of the elements equal to the pivot
+ */
+template<typename T, typename Compare>
+std::pair<std::ptrdiff_t, std::ptrdiff_t> parallel_partition_single_pivot(T* a, std::ptrdiff_t low, std::ptrdiff_t high, std::ptrdiff_t pivotIndex, Compare comp, ThreadPool& pool, int chunks) {
+    if constexpr (use_simd_partition_v<T, Compare> || use_block_partition_v<T, Compare>) {
+        const T pivot = a[pivotIndex];
+
+        return with_block_classifier<T, Compare>([&](auto classifier) {
+            using Classifier = decltype(classifier);
+            std::ptrdiff_t gt = parallel_partition_pass<false, Classifier>(a, low, high, pivot, comp, pool, chunks);
+            std::ptrdiff_t lt = parallel_partition_pass<true, Classifier>(a, low, gt, pivot, comp, pool, chunks);
+            return std::make_pair(lt, gt - 1);
+        });
+    } else {
+        (void)pool;
+        (void)chunks;
+        return partition_single_pivot(a, low, high, pivotIndex, pivotIndex, comp);
+    }
+}
+
+/**
+ * @brief Number of threads a parallel partition of 'size' elements should use.
+ *
+ * Bounded by the concurrency budget of the running sort and by
+ * MIN_PARALLEL_PARTITION_CHUNK elements per thread. Below
+ * PARALLEL_PARTITION_THRESHOLD, or if fewer than 2 threads would take part,
+ * the sequential kernels are used (returns 1).
+ */
+inline int parallel_partition_chunks(ThreadPool& pool, std::ptrdiff_t size) {
+    if (size < PARALLEL_PARTITION_THRESHOLD) return 1;
+    std::ptrdiff_t chunks = std::min(concurrency_budget(pool), size / MIN_PARALLEL_PARTITION_CHUNK);
+    return chunks < 2 ? 1 : static_cast<int>(chunks);
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_PARALLEL_PARALLEL_PARTITION_HPP
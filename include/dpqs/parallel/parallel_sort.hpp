@@ -7,6 +7,7 @@
 #include "dpqs/parallel/buffer_manager.hpp"
 #include "dpqs/parallel/completer.hpp"
 #include "dpqs/parallel/sorter.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
 #include "dpqs/utils.hpp"
 #include "dpqs/partition.hpp"
 #include "dpqs/insertion_sort.hpp"
@@ -17,7 +18,7 @@ namespace dual_pivot {
 // Forward declarations
 template<typename T, typename Compare> void parallelQuickSort(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp);
 
-template<typename T, typename Compare>
+template<typename T, typename Compare, typename PivotSampler = DefaultPivotSampler>
 /**
  * @brief Core Parallel Sort Task.
  *
@@ -49,6 +50,7 @@ template<typename T, typename Compare>
  *
  * @tparam T The type of elements in the array.
  * @tparam Compare The type of the comparison function object.
+ * @tparam PivotSampler Pivot selection policy (see pivot_sampling.hpp).
  *
  * @param a Pointer to the first element of the array being sorted.
  * @param bits A bitmask integer tracking recursion depth and partition origin.
@@ -65,7 +67,7 @@ template<typename T, typename Compare>
  *    - If the range is very small, uses standard Insertion Sort.
  *    - If recursion depth is too high (Introsort), switches to Heap Sort to guarantee O(N log N).
  *
- * 2. **Pivot Selection Calculation:**
+ * 2. **Pivot Selection Calculation (default five-point sampler):**
  *    The algorithm selects 5 equidistant points to sample the array for dual pivots.
  *    Given `size = high - low`, the step size is calculated to distribute points across the range.
  *
@@ -97,8 +99,12 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
     // Ideally, we process the smallest segment in this loop (Tail Call Elimination equivalent)
     // while pushing larger segments to the thread pool.
     while (high - low > MIN_PARALLEL_SORT_SIZE) {
+        // Another task of this sort has thrown (the result is discarded anyway),
+        // or the caller stopped the sort
+        if (ThreadPool::cancellation_requested() || sort_stop_requested()) {
+            return;
+        }
         std::ptrdiff_t size = high - low; // Size of the current range
-        std::ptrdiff_t end = high - 1;    // Inclusive index of the last element
 
         // OPTIMIZATION: Mixed Insertion Sort
         // If the recursion depth is deep (bits are high) or bit 0 is set (indicating right-most or derived part),
@@ -125,29 +131,28 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
             return;
         }
 
-        // Pivot Selection Strategy (5 points):
-        // Calculate 5 equidistant points (e1, e2, e3, e4, e5) to sample the array.
-        //
-        std::ptrdiff_t step = (size >> 3) * 3 + 3;
-        std::ptrdiff_t e1 = low + step;
-        std::ptrdiff_t e5 = end - step;
-        std::ptrdiff_t e3 = (e1 + e5) >> 1;
-        std::ptrdiff_t e2 = (e1 + e3) >> 1;
-        std::ptrdiff_t e4 = (e3 + e5) >> 1;
-
-        // Sort the 5 distinct sample elements.
-        sort5_network(a, e1, e2, e3, e4, e5, comp);
+        // Pivot Selection Strategy:
+        // The PivotSampler policy samples the range (5 equidistant points by default,
+        // see pivot_sampling.hpp) and reports the pivot candidates.
+        PivotSample sample = PivotSampler::select(a, low, high, comp);
 
         std::ptrdiff_t lower, upper; // Output partition boundaries
 
+        // Ranges far above MIN_PARALLEL_SORT_SIZE are partitioned by several threads,
+        // so the first levels of the recursion do not leave the pool idle.
+        auto& pool = getThreadPool();
+        int chunks = parallel_partition_chunks(pool, size);
+
         // Dual-Pivot Condition:
-        // Ensure the selected pivots are distinct enough.
-        // e1 and e5 are chosen as Left (P1) and Right (P2) pivots.
-        // We need P1 < P2. AND strict ordering between the samples helps guarantee good partitioning.
-        if (comp(a[e1], a[e2]) && comp(a[e2], a[e3]) && comp(a[e3], a[e4]) && comp(a[e4], a[e5])) {
+        // The sampler reports whether the sample was free of duplicates. We need P1 < P2,
+        // and strict ordering between the samples helps guarantee good partitioning.
+        if (sample.distinct) {
             // Perform Dual-Pivot Partitioning.
             // Rearranges array into [ < P1 | P1 <= .. <= P2 | > P2 ]
-            auto pivotIndices = partition_dual_pivot(a, low, high, e1, e5, comp);
+            // Cheap comparators on trivially copyable types get the branchless block kernel.
+            auto pivotIndices = chunks > 1
+                ? parallel_partition_dual_pivot(a, low, high, sample.pivot1, sample.pivot2, comp, pool, chunks)
+                : partition_dual_pivot_auto(a, low, high, sample.pivot1, sample.pivot2, comp);
             lower = pivotIndices.first;   // End of Left part
             upper = pivotIndices.second;  // Start of Right part
 
@@ -166,16 +171,19 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
             if (ranges[1].sz < ranges[2].sz) std::swap(ranges[1], ranges[2]);
             if (ranges[0].sz < ranges[1].sz) std::swap(ranges[0], ranges[1]);
 
+            // Pattern-defeating safeguard: an oversized largest part costs extra depth
+            // and gets its pivot sample shuffled before it is handed to the pool.
+            guard_partition<PivotSampler>(a, size, ranges[0].l, ranges[0].h, bits);
+
             // Submit largest 2 ranges to pool
-            auto& pool = getThreadPool();
 
             // Capture values explicitly to avoid array lifetime issues or reference decay
             std::ptrdiff_t r0_l = ranges[0].l, r0_h = ranges[0].h;
             std::ptrdiff_t r1_l = ranges[1].l, r1_h = ranges[1].h;
 
             // Enqueue largest tasks
-            pool.submit([=]{ parallel_sort_task(a, bits | 1, r0_l, r0_h, comp); });
-            pool.submit([=]{ parallel_sort_task(a, bits | 1, r1_l, r1_h, comp); });
+            pool.submit([=]{ parallel_sort_task<T, Compare, PivotSampler>(a, bits | 1, r0_l, r0_h, comp); });
+            pool.submit([=]{ parallel_sort_task<T, Compare, PivotSampler>(a, bits | 1, r1_l, r1_h, comp); });
 
             // LOOP OPTIMIZATION (Recursion depth capping):
             // The current thread ITERATES on the smallest range (ranges[2]).
@@ -186,8 +194,10 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
         } else {
             // Fallback: Single-Pivot Partitioning
             // If the 5 samples were not strictly distinct, Dual-Pivot might not be efficient.
-            // Use e3 (median of samples) as single pivot.
-            auto pivotIndices = partition_single_pivot(a, low, high, e3, e3, comp);
+            // Use the median of the samples as single pivot.
+            auto pivotIndices = chunks > 1
+                ? parallel_partition_single_pivot(a, low, high, sample.median, comp, pool, chunks)
+                : partition_single_pivot(a, low, high, sample.median, sample.median, comp);
             lower = pivotIndices.first;
             upper = pivotIndices.second;
 
@@ -195,18 +205,22 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
             std::ptrdiff_t left_size = lower - low;
             std::ptrdiff_t right_size = high - (upper + 1);
 
-            auto& pool = getThreadPool();
+            if (left_size > right_size) {
+                guard_partition<PivotSampler>(a, size, low, lower, bits);
+            } else {
+                guard_partition<PivotSampler>(a, size, upper + 1, high, bits);
+            }
 
             // "Push Larger, Iterate Smaller" Strategy for Single Pivot case
             if (left_size > right_size) {
                 // Left is bigger -> Push to pool
-                pool.submit([=]{ parallel_sort_task(a, bits | 1, low, lower, comp); });
+                pool.submit([=]{ parallel_sort_task<T, Compare, PivotSampler>(a, bits | 1, low, lower, comp); });
                 // Iterate on Right (smaller)
                 low = upper + 1;
                 // high remains high
             } else {
                 // Right is bigger -> Push to pool
-                pool.submit([=]{ parallel_sort_task(a, bits | 1, upper + 1, high, comp); });
+                pool.submit([=]{ parallel_sort_task<T, Compare, PivotSampler>(a, bits | 1, upper + 1, high, comp); });
                 // Iterate on Left (smaller)
                 high = lower;
                 // low remains low
@@ -217,16 +231,59 @@ void parallel_sort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high,
     // Process remainder sequentially.
     // Once the segment size drops below MIN_PARALLEL_SORT_SIZE, we stop parallelizing
     // and just run standard Sequential Dual-Pivot Quicksort.
-    sort_sequential<T, Compare>(nullptr, a, bits, low, high, comp);
+    sort_sequential<T, Compare, PivotSampler>(nullptr, a, bits, low, high, comp);
 }
 
-template<typename T, typename Compare>
+template<typename T, typename Compare, typename PivotSampler = DefaultPivotSampler>
 void parallelQuickSort(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, int parallelism = 0) {
     auto& pool = getThreadPool(parallelism);
-    // Initial task submission: The entire array is one task.
-    pool.submit([=]{ parallel_sort_task(a, bits, low, high, comp); });
-    // Wait for all tasks to complete (barrier).
-    pool.wait_for_completion();
+    // Each call owns a task group: the sub-tasks submitted by parallel_sort_task
+    // inherit it, so concurrent sorts on the shared pool only wait for their own tree.
+    // The group's budget caps the threads (caller included) working on this sort.
+    TaskGroup group(parallelism);
+    // Initial task submission: The entire array is one task. Nearly sorted, reverse
+    // sorted and sawtooth inputs have their runs scanned and merged on the threads
+    // of this sort instead; the partitions are not scanned again until they are
+    // sequential (a failed scan of a nearly sorted partition costs a pass per level).
+    pool.submit(group, [=]{
+        if (high - low > MIN_TRY_MERGE_SIZE && try_merge_runs(a, low, high - low, comp, true)) {
+            return;
+        }
+        parallel_sort_task<T, Compare, PivotSampler>(a, bits, low, high, comp);
+    });
+    // Wait for this sort's tasks to complete (barrier).
+    pool.wait(group);
+}
+
+/**
+ * @brief Parallel merge sort of the Sorter tree (Java's parallel sort).
+ *
+ * With a negative (even) depth the range is split 2^-depth ways, each part is
+ * quicksorted by a Sorter that forks its large partitions, and the parts are
+ * merged back level by level through a buffer of the range's size; with depth
+ * 0 the root Sorter quicksorts the whole range. The tree's nodes come from one
+ * node arena and complete without locks, so no thread blocks on a node: like
+ * parallelQuickSort, the caller only waits for the sort's task group.
+ *
+ * @param depth Merge depth, 0 or negative and even (see getMergeDepth)
+ */
+template<typename T, typename Compare>
+void parallelMergeSort(T* a, int depth, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, int parallelism = 0) {
+    std::ptrdiff_t size = high - low;
+    auto& pool = getThreadPool(parallelism);
+    TaskGroup group(parallelism);
+    TaskTree<Compare> tree(comp);
+    // First touched within the sort's budget, before the group runs the sort
+    ScratchBuffer<T> b(depth < 0 ? static_cast<std::size_t>(size) : 0, group);
+    auto* root = tree.nodes.template create<Sorter<T, Compare>>(nullptr, &tree, a, b.data(), low, size, low, depth);
+    // As in parallelQuickSort, only the whole range is scanned for runs on all threads
+    pool.submit(group, [=] {
+        if (size > MIN_TRY_MERGE_SIZE && try_merge_runs(a, low, size, comp, true)) {
+            return;
+        }
+        root->compute();
+    });
+    pool.wait(group);
 }
 
 /**
@@ -241,7 +298,8 @@ void parallelSort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high
     // Only parallelize if we have >1 thread and the array is large enough.
     if (parallelism > 1 && size > MIN_PARALLEL_SORT_SIZE) {
         int depth = getDepth(parallelism, size >> 12);
-        // Always use QuickSort for now as MergeSort is not adapted to V3 pool
+        // QuickSort: its top levels are partitioned by several threads, where
+        // parallelMergeSort pays a merge pass per level for its parallelism
         parallelQuickSort(a, depth, low, high, comp, parallelism);
     } else {
         // Fallback for single-thread or small arrays
@@ -249,28 +307,6 @@ void parallelSort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high
     }
 }
 
-template<typename T, typename Compare>
-class AdvancedSorter : public Sorter<T, Compare> {
-private:
-    AdvancedSorter* parent;
-    T* a;
-    T* b;
-    std::ptrdiff_t low;
-    std::ptrdiff_t size;
-    std::ptrdiff_t offset;
-    int depth;
-    Compare comp;
-
-public:
-    AdvancedSorter(AdvancedSorter* parent, T* a, T* b, std::ptrdiff_t low, std::ptrdiff_t size, std::ptrdiff_t offset, int depth, Compare comp)
-        : Sorter<T, Compare>(parent, a, b, low, size, offset, depth, comp),
-          parent(parent), a(a), b(b), low(low), size(size), offset(offset), depth(depth), comp(comp) {}
-
-    void compute() override {
-        Sorter<T, Compare>::compute();
-    }
-};
-
 } // namespace dual_pivot
 
 #endif // DPQS_PARALLEL_PARALLEL_SORT_HPP
@@ -0,0 +1,480 @@
+#ifndef DPQS_PARALLEL_SAMPLESORT_HPP
+#define DPQS_PARALLEL_SAMPLESORT_HPP
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <thread>
+#include <cmath>
+#include <cstdint>
+#include "dpqs/constants.hpp"
+#include "dpqs/parallel/parallel_sort.hpp"
+
+namespace dual_pivot {
+
+/**
+ * @brief Branchless search tree over the splitters of one samplesort level.
+ *
+ * The k - 1 splitters are stored in heap order, so classifying an element is
+ * log2(k) steps of i = 2i + comp(tree[i], x) without a single branch. Element x
+ * lands in bucket b = number of splitters less than x.
+ *
+ * Duplicate splitters mean a heavily repeated key. They are dropped, and every
+ * bucket b is split in two: 2b for the elements less than splitter b, 2b + 1
+ * for the elements equal to it. Equality buckets are sorted by construction.
+ */
+template<typename T, typename Compare>
+class SplitterTree {
+public:
+    /// Elements classified together, their tree descents are independent
+    static constexpr int BATCH = 8;
+
+    /**
+     * @param splitters Sorted splitter candidates (at least one)
+     */
+    SplitterTree(const std::vector<T>& splitters, Compare comp) : comp(comp) {
+        for (const T& splitter : splitters) {
+            if (!sorted.empty() && !comp(sorted.back(), splitter)) {
+                equal = true;
+                continue;
+            }
+            sorted.push_back(splitter);
+        }
+        while ((std::size_t(1) << log_leaves) <= sorted.size()) ++log_leaves;
+        leaves = std::size_t(1) << log_leaves;
+
+        // Padding repeats the largest splitter, the buckets in between stay empty
+        T largest = sorted.back();
+        sorted.resize(leaves, largest);
+        tree.assign(leaves, largest);
+        build(1, 0, leaves - 1);
+    }
+
+    std::size_t bucket_count() const { return equal ? 2 * leaves : leaves; }
+
+    bool has_equal_buckets() const { return equal; }
+
+    /// Whether bucket b only holds copies of one splitter
+    bool is_equal_bucket(std::size_t b) const { return equal && (b & 1) != 0; }
+
+    std::size_t classify(const T& x) {
+        std::size_t i = 1;
+        for (int level = 0; level < log_leaves; ++level) {
+            i = 2 * i + static_cast<std::size_t>(comp(tree[i], x));
+        }
+        return leaf_bucket(i - leaves, x);
+    }
+
+    /**
+     * @brief Classifies [begin, end) and calls consume(bucket, element) in order.
+     *
+     * A batch is classified completely before its elements are consumed, so
+     * consume may overwrite elements of the range that it has already seen.
+     */
+    template<typename Consumer>
+    void classify(T* begin, T* end, Consumer&& consume) {
+        T* p = begin;
+        for (; end - p >= BATCH; p += BATCH) {
+            std::size_t index[BATCH];
+            for (int u = 0; u < BATCH; ++u) index[u] = 1;
+            for (int level = 0; level < log_leaves; ++level) {
+                for (int u = 0; u < BATCH; ++u) {
+                    index[u] = 2 * index[u] + static_cast<std::size_t>(comp(tree[index[u]], p[u]));
+                }
+            }
+            for (int u = 0; u < BATCH; ++u) index[u] = leaf_bucket(index[u] - leaves, p[u]);
+            for (int u = 0; u < BATCH; ++u) consume(index[u], p[u]);
+        }
+        for (; p < end; ++p) {
+            consume(classify(*p), *p);
+        }
+    }
+
+private:
+    std::vector<T> sorted;  // Unique splitters, padded to 'leaves' entries
+    std::vector<T> tree;    // Heap order, root at 1
+    int log_leaves = 1;
+    std::size_t leaves = 2;
+    bool equal = false;
+    Compare comp;
+
+    void build(std::size_t node, std::size_t low, std::size_t high) {
+        if (low >= high) return;
+        std::size_t middle = low + (high - low) / 2;
+        tree[node] = sorted[middle];
+        build(2 * node, low, middle);
+        build(2 * node + 1, middle + 1, high);
+    }
+
+    std::size_t leaf_bucket(std::size_t leaf, const T& x) {
+        if (!equal) return leaf;
+        return 2 * leaf + static_cast<std::size_t>(leaf + 1 < leaves && !comp(x, sorted[leaf]));
+    }
+};
+
+/**
+ * @brief Draws a random sample and picks the splitters of one samplesort level.
+ *
+ * The sample is moved to the front of the range and sorted there. The xorshift
+ * generator is seeded from the range size, so sorting stays deterministic.
+ */
+template<typename T, typename Compare>
+SplitterTree<T, Compare> select_splitters(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp) {
+    std::ptrdiff_t size = high - low;
+    std::ptrdiff_t buckets = std::ptrdiff_t(1) << SAMPLESORT_LOG_BUCKETS;
+    std::ptrdiff_t oversampling = std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(SAMPLESORT_OVERSAMPLING * std::log2(static_cast<double>(size))));
+    std::ptrdiff_t sample_size = std::max<std::ptrdiff_t>(1, std::min(size / 2, oversampling * buckets - 1));
+
+    std::uint64_t state = static_cast<std::uint64_t>(size) * 0x9E3779B97F4A7C15ULL + 1;
+    for (std::ptrdiff_t i = 0; i < sample_size; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::ptrdiff_t j = i + static_cast<std::ptrdiff_t>(state % static_cast<std::uint64_t>(size - i));
+        std::swap(a[low + i], a[low + j]);
+    }
+    sort_sequential<T, Compare>(nullptr, a, 0, low, low + sample_size, comp);
+
+    std::ptrdiff_t count = std::min(buckets - 1, sample_size);
+    std::vector<T> splitters;
+    splitters.reserve(count);
+    for (std::ptrdiff_t i = 1; i <= count; ++i) {
+        splitters.push_back(a[low + i * sample_size / (count + 1)]);
+    }
+    return SplitterTree<T, Compare>(splitters, comp);
+}
+
+/**
+ * @brief In-place parallel distribution of one range into the buckets of a SplitterTree.
+ *
+ * Follows IPS4o ("In-place Parallel Super Scalar Samplesort", Axtmann, Witt,
+ * Ferizovic, Sanders, ESA 2017). The range is read and written once, in blocks
+ * of BLOCK elements, with O(threads * buckets * BLOCK) extra memory:
+ *
+ * 1. Classification: every thread owns a block-aligned stripe. Its elements go
+ *    to one buffer block per bucket; full buffers are written back to the front
+ *    of the stripe (behind the read position).
+ * 2. Empty block movement: each bucket region (its bucket boundaries rounded up
+ *    to blocks) is compacted so its full blocks come first.
+ * 3. Block permutation: threads pop unprocessed blocks from the bucket regions
+ *    and swap them to their bucket's next write slot, which is tracked in one
+ *    atomic word per bucket. The last block may cross the end of the range and
+ *    goes to an overflow buffer instead.
+ * 4. Cleanup: partial blocks (buffers, and the part of a bucket's last block
+ *    hanging into the next bucket) fill the gaps at both ends of each bucket.
+ */
+template<typename T, typename Compare>
+class SampleSortPartitioner {
+public:
+    static constexpr std::ptrdiff_t BLOCK = std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(SAMPLESORT_BLOCK_BYTES / sizeof(T)));
+
+    SampleSortPartitioner(T* a, std::ptrdiff_t low, std::ptrdiff_t high, SplitterTree<T, Compare>& tree,
+                          ThreadPool& pool, int threads)
+        : base(a + low), low(low), size(high - low), tree(tree), pool(pool),
+          threads(std::max(1, threads)),
+          buckets(static_cast<std::ptrdiff_t>(tree.bucket_count())),
+          full_slots(size / BLOCK),
+          scratch(static_cast<std::size_t>((std::max(1, threads) * (buckets + 2) + buckets + 1) * BLOCK)),
+          locals(static_cast<std::size_t>(this->threads)),
+          pointers(new BucketPointers[buckets]) {
+        T* memory = scratch.data();
+        for (auto& local : locals) {
+            local.buffers = memory;
+            local.hand = memory + buckets * BLOCK;
+            local.spare = local.hand + BLOCK;
+            local.fill.assign(buckets, 0);
+            local.flushed.assign(buckets, 0);
+            memory += (buckets + 2) * BLOCK;
+        }
+        overhang = memory;
+        overflow = memory + buckets * BLOCK;
+    }
+
+    /**
+     * @brief Distributes the range.
+     *
+     * @return bucket_count() + 1 boundaries: bucket b is [result[b], result[b + 1])
+     */
+    std::vector<std::ptrdiff_t> partition() {
+        for_each_thread([this](int i) { classify_stripe(i); });
+
+        starts.assign(buckets + 1, 0);
+        blocks.assign(buckets, 0);
+        for (std::ptrdiff_t b = 0; b < buckets; ++b) {
+            std::ptrdiff_t count = 0;
+            for (const auto& local : locals) {
+                count += local.flushed[b] * BLOCK + local.fill[b];
+                blocks[b] += local.flushed[b];
+            }
+            starts[b + 1] = starts[b] + count;
+        }
+
+        for_each_bucket_range([this](std::ptrdiff_t b) { move_empty_blocks(b); });
+        for_each_thread([this](int i) { permute_blocks(i); });
+
+        if (overflow_used) {
+            std::move(overflow, overflow + (size - full_slots * BLOCK), base + full_slots * BLOCK);
+        }
+        for_each_bucket_range([this](std::ptrdiff_t b) { save_overhang(b); });
+        for_each_bucket_range([this](std::ptrdiff_t b) { fill_gaps(b); });
+
+        std::vector<std::ptrdiff_t> bounds(buckets + 1);
+        for (std::ptrdiff_t b = 0; b <= buckets; ++b) bounds[b] = low + starts[b];
+        return bounds;
+    }
+
+private:
+    struct Local {
+        T* buffers = nullptr;                // One buffer block per bucket
+        T* hand = nullptr;                   // Block being moved by the permutation
+        T* spare = nullptr;                  // Block it displaced
+        std::vector<std::ptrdiff_t> fill;    // Elements in each bucket's buffer
+        std::vector<std::ptrdiff_t> flushed; // Full blocks written per bucket
+        std::ptrdiff_t begin = 0, end = 0, write = 0;
+    };
+
+    // Write slot in the high half, read slot in the low half, so taking a slot
+    // from either end is one atomic step that sees the other end.
+    struct alignas(64) BucketPointers {
+        std::atomic<std::uint64_t> write_read{0};
+        std::atomic<int> reading{0};
+    };
+
+    static constexpr std::uint64_t READ_MASK = 0xFFFFFFFFULL;
+
+    T* base;
+    std::ptrdiff_t low, size;
+    SplitterTree<T, Compare>& tree;
+    ThreadPool& pool;
+    int threads;
+    std::ptrdiff_t buckets;
+    std::ptrdiff_t full_slots;  // Blocks that end inside the range
+    ScratchBuffer<T> scratch;
+    std::vector<Local> locals;
+    std::unique_ptr<BucketPointers[]> pointers;
+    T* overhang = nullptr;      // Up to one partial block per bucket
+    T* overflow = nullptr;      // Block slot crossing the end of the range
+    std::atomic<bool> overflow_used{false};
+    std::vector<std::ptrdiff_t> starts;  // Bucket boundaries relative to base
+    std::vector<std::ptrdiff_t> blocks;  // Full blocks per bucket
+
+    static std::ptrdiff_t round_up(std::ptrdiff_t index) { return (index + BLOCK - 1) / BLOCK; }
+
+    template<typename Body>
+    void for_each_thread(const Body& body) {
+        if (threads == 1) {
+            body(0);
+        } else {
+            parallel_for_chunks(pool, threads, body);
+        }
+    }
+
+    template<typename Body>
+    void for_each_bucket_range(const Body& body) {
+        for_each_thread([&](int i) {
+            for (std::ptrdiff_t b = buckets * i / threads; b < buckets * (i + 1) / threads; ++b) body(b);
+        });
+    }
+
+    void classify_stripe(int i) {
+        Local& local = locals[i];
+        local.begin = full_slots * i / threads * BLOCK;
+        local.end = (i == threads - 1) ? size : full_slots * (i + 1) / threads * BLOCK;
+        local.write = local.begin;
+
+        SplitterTree<T, Compare> own_tree = tree;
+        T* buffers = local.buffers;
+        std::ptrdiff_t* fill = local.fill.data();
+        own_tree.classify(base + local.begin, base + local.end, [&](std::size_t b, T& x) {
+            T* buffer = buffers + static_cast<std::ptrdiff_t>(b) * BLOCK;
+            buffer[fill[b]] = std::move(x);
+            if (++fill[b] == BLOCK) {
+                // At least BLOCK elements were read since the last write, so this never overtakes the reads
+                std::move(buffer, buffer + BLOCK, base + local.write);
+                local.write += BLOCK;
+                fill[b] = 0;
+                ++local.flushed[b];
+            }
+        });
+    }
+
+    bool is_full(std::ptrdiff_t slot) const {
+        int i = static_cast<int>(std::upper_bound(locals.begin(), locals.end(), slot * BLOCK,
+            [](std::ptrdiff_t position, const Local& local) { return position < local.begin; }) - locals.begin()) - 1;
+        return slot * BLOCK < locals[i].write;
+    }
+
+    void move_empty_blocks(std::ptrdiff_t b) {
+        std::ptrdiff_t first = round_up(starts[b]);
+        std::ptrdiff_t last = std::min(round_up(starts[b + 1]), full_slots);
+        std::ptrdiff_t left = first, right = std::max(first, last);
+        while (true) {
+            while (left < right && is_full(left)) ++left;
+            while (left < right && !is_full(right - 1)) --right;
+            if (left >= right) break;
+            std::move(base + (right - 1) * BLOCK, base + right * BLOCK, base + left * BLOCK);
+            ++left;
+            --right;
+        }
+        pointers[b].write_read.store(static_cast<std::uint64_t>(first) << 32 | static_cast<std::uint64_t>(left),
+                                     std::memory_order_relaxed);
+        pointers[b].reading.store(0, std::memory_order_relaxed);
+    }
+
+    // Takes the last unprocessed block of bucket b's region into 'out'
+    bool pop_block(std::ptrdiff_t b, T* out) {
+        BucketPointers& bucket = pointers[b];
+        bucket.reading.fetch_add(1, std::memory_order_seq_cst);
+        std::uint64_t write_read = bucket.write_read.load(std::memory_order_seq_cst);
+        while (true) {
+            std::uint64_t write = write_read >> 32, read = write_read & READ_MASK;
+            if (read <= write) {
+                bucket.reading.fetch_sub(1, std::memory_order_release);
+                return false;
+            }
+            if (bucket.write_read.compare_exchange_weak(write_read, write_read - 1, std::memory_order_seq_cst)) {
+                T* block = base + static_cast<std::ptrdiff_t>(read - 1) * BLOCK;
+                std::move(block, block + BLOCK, out);
+                bucket.reading.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    void permute_blocks(int i) {
+        Local& local = locals[i];
+        SplitterTree<T, Compare> own_tree = tree;
+        std::ptrdiff_t b = buckets * i / threads;
+
+        // Regions never get new unprocessed blocks, so every bucket is found empty once
+        for (std::ptrdiff_t empty = 0; empty < buckets;) {
+            if (!pop_block(b, local.hand)) {
+                b = (b + 1 == buckets) ? 0 : b + 1;
+                ++empty;
+                continue;
+            }
+            std::size_t dest = own_tree.classify(local.hand[0]);
+            while (true) {
+                BucketPointers& bucket = pointers[dest];
+                std::uint64_t write_read = bucket.write_read.fetch_add(std::uint64_t(1) << 32, std::memory_order_seq_cst);
+                std::ptrdiff_t write = static_cast<std::ptrdiff_t>(write_read >> 32);
+                std::ptrdiff_t read = static_cast<std::ptrdiff_t>(write_read & READ_MASK);
+                T* target = base + write * BLOCK;
+
+                if (write < read) {
+                    // Unprocessed block: keep it if it is already home, else swap
+                    std::size_t displaced = own_tree.classify(target[0]);
+                    if (displaced == dest) continue;
+                    std::move(target, target + BLOCK, local.spare);
+                    std::move(local.hand, local.hand + BLOCK, target);
+                    std::swap(local.hand, local.spare);
+                    dest = displaced;
+                    continue;
+                }
+
+                // Empty slot; a thread may still be copying out the block it popped there
+                while (bucket.reading.load(std::memory_order_acquire) != 0) {
+                    std::this_thread::yield();
+                }
+                if (write == full_slots) {
+                    target = overflow;
+                    overflow_used.store(true, std::memory_order_relaxed);
+                }
+                std::move(local.hand, local.hand + BLOCK, target);
+                break;
+            }
+        }
+    }
+
+    // Copies the part of bucket b's last block that lies in the next bucket
+    void save_overhang(std::ptrdiff_t b) {
+        std::ptrdiff_t blocks_begin = round_up(starts[b]) * BLOCK;
+        std::ptrdiff_t blocks_end = blocks_begin + blocks[b] * BLOCK;
+        std::ptrdiff_t from = std::max(blocks_begin, starts[b + 1]);
+        T* out = overhang + b * BLOCK;
+        for (std::ptrdiff_t p = from; p < blocks_end; ++p) {
+            *out++ = std::move(p < size ? base[p] : overflow[p - full_slots * BLOCK]);
+        }
+    }
+
+    // Fills bucket b's gaps before and after its full blocks
+    void fill_gaps(std::ptrdiff_t b) {
+        std::ptrdiff_t blocks_begin = round_up(starts[b]) * BLOCK;
+        std::ptrdiff_t blocks_end = blocks_begin + blocks[b] * BLOCK;
+        std::ptrdiff_t head_end = std::min(blocks_begin, starts[b + 1]);
+        std::ptrdiff_t tail_begin = std::min(blocks_end, starts[b + 1]);
+        std::ptrdiff_t position = starts[b];
+        auto put = [&](T* first, std::ptrdiff_t count) {
+            for (std::ptrdiff_t k = 0; k < count; ++k) {
+                if (position == head_end) position = tail_begin;
+                base[position++] = std::move(first[k]);
+            }
+        };
+
+        put(overhang + b * BLOCK, std::max<std::ptrdiff_t>(0, blocks_end - std::max(blocks_begin, starts[b + 1])));
+        for (auto& local : locals) {
+            put(local.buffers + b * BLOCK, local.fill[b]);
+        }
+    }
+};
+
+/**
+ * @brief One samplesort level on a task of the pool, then one task per bucket.
+ *
+ * Buckets that are still at least SAMPLESORT_THRESHOLD elements get another
+ * samplesort level; the others continue with parallel_sort_task (or a
+ * sequential sort when they are small). Equality buckets are already sorted.
+ */
+template<typename T, typename Compare>
+void parallel_samplesort_task(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp) {
+    std::ptrdiff_t size = high - low;
+    if (size < 2 || ThreadPool::cancellation_requested() || sort_stop_requested()) return;
+
+    auto& pool = getThreadPool();
+    SplitterTree<T, Compare> tree = select_splitters(a, low, high, comp);
+    int threads = parallel_partition_chunks(pool, size);
+    std::vector<std::ptrdiff_t> bounds = SampleSortPartitioner<T, Compare>(a, low, high, tree, pool, threads).partition();
+
+    bits += DELTA;
+    for (std::size_t b = 0; b + 1 < bounds.size(); ++b) {
+        std::ptrdiff_t l = bounds[b], h = bounds[b + 1];
+        if (h - l < 2 || tree.is_equal_bucket(b)) continue;
+
+        // Every bucket but the first has a sentinel on its left
+        int bucket_bits = (l == low) ? bits : (bits | 1);
+        if (h - l <= MIN_PARALLEL_SORT_SIZE) {
+            sort_sequential<T, Compare>(nullptr, a, bucket_bits, l, h, comp);
+        } else if (h - l >= SAMPLESORT_THRESHOLD && h - l < size) {
+            pool.submit([=]{ parallel_samplesort_task<T, Compare>(a, bucket_bits, l, h, comp); });
+        } else {
+            pool.submit([=]{ parallel_sort_task<T, Compare>(a, bucket_bits, l, h, comp); });
+        }
+    }
+}
+
+/**
+ * @brief Parallel samplesort entry, same contract as parallelQuickSort.
+ *
+ * Meant for ranges of SAMPLESORT_THRESHOLD elements and more, where the sort is
+ * bound by memory bandwidth: each samplesort level reads and writes the range
+ * once for 256 buckets, instead of once per quicksort level.
+ */
+template<typename T, typename Compare>
+void parallelSampleSort(T* a, int bits, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, int parallelism = 0) {
+    auto& pool = getThreadPool(parallelism);
+    TaskGroup group(parallelism);
+    pool.submit(group, [=]{
+        // Structured input merges its runs instead, as in parallelQuickSort
+        if (try_merge_runs(a, low, high - low, comp, true)) {
+            return;
+        }
+        parallel_samplesort_task<T, Compare>(a, bits, low, high, comp);
+    });
+    pool.wait(group);
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_PARALLEL_SAMPLESORT_HPP
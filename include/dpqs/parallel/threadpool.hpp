@@ -2,6 +2,7 @@
 #define DPQS_PARALLEL_THREADPOOL_HPP
 
 #include <vector>
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <thread>
@@ -11,6 +12,16 @@
 #include <atomic>
 #include <random>
 #include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <cstdlib>
+#include "dpqs/parallel/topology.hpp"
+#include "dpqs/stop_condition.hpp"
 
 namespace dual_pivot {
 
@@ -18,190 +29,1054 @@ namespace dual_pivot {
 // -1 indicates an external thread (e.g., main thread)
 inline thread_local int thread_index = -1;
 
+/**
+ * @brief Latch counting the unfinished tasks of one task tree.
+ *
+ * Every task belongs to a group. ThreadPool::submit(group, f) starts a tree in
+ * a group, and tasks submitted while a task runs inherit the group of that task,
+ * so a whole recursive sort is tracked by the group its root was submitted to.
+ * ThreadPool::wait(group) then returns as soon as that tree is done, no matter
+ * what other callers are running on the same pool.
+ *
+ * A group may carry a concurrency budget: at most max_threads threads run its
+ * tasks at the same time (the waiting caller counts as one of them). The budget
+ * is per group, so sorts with different parallelism share one pool. A group
+ * created with inherit_budget inside a task counts against the budget of that
+ * task's group instead, so nested fan-out (chunks of a parallel partition, a
+ * parallel merge) stays within the budget of the sort.
+ *
+ * An exception thrown by a task is caught by the pool and kept in the group
+ * (the first one only), and the group is cancelled: its tasks that have not
+ * started yet are dropped, and running ones may stop early by polling
+ * ThreadPool::cancellation_requested(). ThreadPool::wait(group) rethrows the
+ * exception once every task has finished. A group created inside a task is
+ * cancelled along with the group of that task.
+ *
+ * A group also carries the stop condition (SortStop) of the thread that
+ * created it, and its tasks run with that condition set.
+ *
+ * A group must outlive its tasks, i.e. wait on it before destroying it.
+ */
+class TaskGroup {
+public:
+    struct inherit_budget_t {};
+    /// Tag for a group sharing the budget of the running task's group (unlimited outside tasks)
+    static constexpr inherit_budget_t inherit_budget{};
+
+    /// @param max_threads Concurrency budget, 0 for unlimited
+    explicit TaskGroup(int max_threads = 0);
+    explicit TaskGroup(inherit_budget_t);
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// Whether all tasks of the group have finished
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    /// Drops the tasks of the group (and of groups created inside them) that have not started yet
+    void cancel() { cancel_flag.store(true, std::memory_order_relaxed); }
+
+    /// Whether the group or the group it was created in has been cancelled
+    bool cancelled() const {
+        for (const TaskGroup* group = this; group != nullptr; group = group->parent) {
+            if (group->cancel_flag.load(std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    /// Keeps 'error' for wait() unless an earlier exception is kept, and cancels the group
+    void capture_exception(std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!first_error) first_error = error;
+        }
+        cancel();
+    }
+
+    /// Number of submitted but unfinished tasks
+    long pending_tasks() const { return pending.load(std::memory_order_relaxed); }
+
+    /// Concurrency budget (0 for unlimited)
+    int max_threads() const { return budget->limit; }
+
+    /// Threads currently counted against the budget
+    int active_threads() const { return budget->active.load(std::memory_order_relaxed); }
+
+private:
+    friend class ThreadPool;
+
+    // Group with an explicit parent and stop condition (the pool's default group
+    // has neither), counting against the budget of 'budget_group' (its own if null)
+    TaskGroup(int max_threads, TaskGroup* parent, const SortStop* stop, TaskGroup* budget_group = nullptr)
+        : limit(max_threads > 0 ? max_threads : 0), parent(parent), stop(stop),
+          budget(budget_group != nullptr ? budget_group : this) {}
+
+    void add() { pending.fetch_add(1, std::memory_order_relaxed); }
+
+    // Takes one unit of the budget if available
+    bool try_enter() {
+        if (budget->limit == 0) return true;
+        int current = budget->active.load(std::memory_order_relaxed);
+        while (current < budget->limit) {
+            if (budget->active.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns one unit; true if the budget was used up, so threads that skipped
+    // the group's tasks may be parked and should be woken for the freed unit
+    bool leave() {
+        if (budget->limit == 0) return false;
+        return budget->active.fetch_sub(1, std::memory_order_release) == budget->limit;
+    }
+
+    // Whether a thread could enter now (racy: try_enter decides)
+    bool has_budget() const {
+        return budget->limit == 0 || budget->active.load(std::memory_order_relaxed) < budget->limit;
+    }
+
+    // Whether both groups count against the same budget
+    bool shares_budget_with(const TaskGroup& other) const { return budget == other.budget; }
+
+    // The last task takes the lock before the count reaches 0: a waiter may
+    // destroy the group as soon as it sees 0, and waiters pass through the lock
+    // on their way out (block_until_done), so it must be released by then.
+    void finish() {
+        long current = pending.load(std::memory_order_relaxed);
+        while (current > 1) {
+            if (pending.compare_exchange_weak(current, current - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            cv.notify_all();
+        }
+    }
+
+    void block_until_done() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return done(); });
+    }
+
+    // After the group is done: rethrows the kept exception and makes the group reusable
+    void rethrow_if_failed() {
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            error = std::exchange(first_error, nullptr);
+        }
+        cancel_flag.store(false, std::memory_order_relaxed);
+        if (error) std::rethrow_exception(error);
+    }
+
+    std::atomic<long> pending{0};
+    const int limit;
+    std::atomic<int> active{0};
+    std::atomic<bool> cancel_flag{false};
+    TaskGroup* const parent;
+    const SortStop* const stop;
+    TaskGroup* const budget; // Group whose limit and active count apply (this one or an ancestor)
+    std::exception_ptr first_error;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+/**
+ * @brief Fixed-size, type-erased unit of work for the thread pool.
+ *
+ * Unlike std::function, a Task never allocates for the callables the sort
+ * submits: trivially copyable closures of up to STORAGE_SIZE bytes (pointers,
+ * indices and a stateless comparator) are stored inline. Other callables are
+ * boxed on the heap as a fallback. A Task itself is trivially copyable, so the
+ * work-stealing deque can move it word by word without locks.
+ *
+ * A Task must be run or discarded exactly once; either releases a boxed callable.
+ */
+class Task {
+public:
+    static constexpr std::size_t SIZE = 64;
+    static constexpr std::size_t STORAGE_SIZE = SIZE - sizeof(void (*)(void*)) - sizeof(TaskGroup*);
+
+    Task() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f, TaskGroup* group = nullptr) : group(group) {
+        using Fn = std::decay_t<F>;
+        if constexpr (is_inline_v<Fn>) {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            invoke = [](void* p, bool run) {
+                if (run) (*std::launder(reinterpret_cast<Fn*>(p)))();
+            };
+        } else {
+            Fn* boxed = new Fn(std::forward<F>(f));
+            std::memcpy(storage, &boxed, sizeof(boxed));
+            invoke = [](void* p, bool run) {
+                Fn* fn;
+                std::memcpy(&fn, p, sizeof(fn));
+                std::unique_ptr<Fn> owner(fn);
+                if (run) (*fn)();
+            };
+        }
+    }
+
+    /// Whether callables of type F are stored inline (no allocation)
+    template<typename F>
+    static constexpr bool is_inline_v = std::is_trivially_copyable_v<F> &&
+        sizeof(F) <= STORAGE_SIZE && alignof(F) <= alignof(std::max_align_t);
+
+    void operator()() { invoke(storage, true); }
+
+    /// Drops the task without running it (a cancelled group)
+    void discard() { invoke(storage, false); }
+
+    explicit operator bool() const { return invoke != nullptr; }
+
+    /// Group the task counts against (nullptr for tasks outside a pool)
+    TaskGroup* get_group() const { return group; }
+
+private:
+    alignas(std::max_align_t) unsigned char storage[STORAGE_SIZE];
+    void (*invoke)(void*, bool) = nullptr;
+    TaskGroup* group = nullptr;
+};
+
+static_assert(sizeof(Task) == Task::SIZE, "Task must fill exactly one cache line");
+static_assert(std::is_trivially_copyable_v<Task>, "Task must be copyable word by word");
+
+/**
+ * @brief Lock-free Chase-Lev work-stealing deque of Tasks.
+ *
+ * Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop,
+ * Cohen, Zappa Nardelli, PPoPP 2013):
+ * - The owner pushes and pops at the bottom (LIFO) with plain loads and stores;
+ *   only popping the last element races with thieves and needs a CAS.
+ * - Thieves steal from the top (FIFO, the largest tasks) with a single CAS.
+ *
+ * Slots are arrays of relaxed atomic words, so a thief reading a slot the owner
+ * is overwriting is a benign race that the CAS on top rejects. The ring grows by
+ * doubling; old rings stay alive until the deque is destroyed because a thief may
+ * still be reading from them.
+ */
+class WorkStealingDeque {
+private:
+    static constexpr std::size_t WORDS = Task::SIZE / sizeof(std::uint64_t);
+
+    struct Slot {
+        std::atomic<std::uint64_t> words[WORDS];
+    };
+
+    struct Ring {
+        std::int64_t capacity;
+        std::unique_ptr<Slot[]> slots;
+
+        explicit Ring(std::int64_t capacity) : capacity(capacity), slots(new Slot[capacity]) {}
+
+        void put(std::int64_t i, const Task& task) {
+            std::uint64_t words[WORDS];
+            std::memcpy(words, &task, sizeof(task));
+            Slot& slot = slots[i & (capacity - 1)];
+            for (std::size_t w = 0; w < WORDS; ++w) {
+                slot.words[w].store(words[w], std::memory_order_relaxed);
+            }
+        }
+
+        Task get(std::int64_t i) const {
+            std::uint64_t words[WORDS];
+            const Slot& slot = slots[i & (capacity - 1)];
+            for (std::size_t w = 0; w < WORDS; ++w) {
+                words[w] = slot.words[w].load(std::memory_order_relaxed);
+            }
+            Task task;
+            std::memcpy(&task, words, sizeof(task));
+            return task;
+        }
+    };
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    std::atomic<Ring*> ring;
+    std::vector<std::unique_ptr<Ring>> rings; // Owner only: current and retired rings
+
+    Ring* grow(Ring* old, std::int64_t b, std::int64_t t) {
+        auto bigger = std::make_unique<Ring>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Ring* result = bigger.get();
+        rings.push_back(std::move(bigger));
+        ring.store(result, std::memory_order_release);
+        return result;
+    }
+
+public:
+    static constexpr std::int64_t INITIAL_CAPACITY = 256;
+
+    WorkStealingDeque() {
+        rings.push_back(std::make_unique<Ring>(INITIAL_CAPACITY));
+        ring.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Push a task to the bottom (Owner only)
+    void push(const Task& task) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Ring* r = ring.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow(r, b, t);
+        }
+        r->put(b, task);
+        // Release store rather than fence + relaxed store: same code on x86, and
+        // ThreadSanitizer (which ignores fences) sees the task published
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Whether the newest task satisfies pred, without taking it (Owner only).
+    // The newest task may also be the oldest one, so pred has the same limits
+    // as in try_steal_if.
+    template<typename Predicate>
+    bool newest_satisfies(Predicate pred) const {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        return pred(ring.load(std::memory_order_relaxed)->get(b - 1));
+    }
+
+    // Pop from bottom only if the newest task satisfies pred (Owner only). A
+    // successful pop returns the task pred accepted: thieves can only take it
+    // by emptying the deque.
+    template<typename Predicate>
+    bool try_pop_if(Task& task, Predicate pred) {
+        return newest_satisfies(pred) && try_pop(task);
+    }
+
+    // Pop from bottom (Owner only)
+    bool try_pop(Task& task) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring* r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        task = r->get(b);
+        if (t == b) {
+            // Last element: race against thieves
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Steal from top (Thieves only)
+    bool try_steal(Task& task) {
+        return try_steal_if(task, [](const Task&) { return true; });
+    }
+
+    // Steal from top only if the oldest task satisfies pred (Thieves only).
+    // pred may see a stale copy; that copy is discarded unless the CAS succeeds,
+    // and pred must not follow its pointers (the task may be long gone) unless
+    // the caller keeps what they point to alive.
+    template<typename Predicate>
+    bool try_steal_if(Task& task, Predicate pred) {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+
+        Ring* r = ring.load(std::memory_order_acquire);
+        Task stolen = r->get(t);
+        if (!pred(stolen)) return false;
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false; // Lost the race against another thief or the owner
+        }
+        task = stolen;
+        return true;
+    }
+
+    // Whether the oldest task satisfies pred, without taking it (same rules as try_steal_if)
+    template<typename Predicate>
+    bool oldest_satisfies(Predicate pred) const {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        return pred(ring.load(std::memory_order_acquire)->get(t));
+    }
+
+    bool empty() const {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+    std::int64_t size() const {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+};
+
 /**
  * @brief Work Stealing Thread Pool (V3)
  *
  * Implements a distributed queue architecture where each thread has its own
- * double-ended queue (deque).
+ * lock-free double-ended queue (Chase-Lev deque).
  * - Owner pushes/pops from bottom (LIFO) for cache locality.
  * - Thieves steal from top (FIFO) to take largest tasks.
- * - Eliminates global mutex contention.
+ * - Threads outside the pool submit through a small injection queue.
+ * - Eliminates global mutex contention and per-task heap allocation.
+ *
+ * Idle workers spin for IDLE_SPIN_ROUNDS rounds of steal attempts, then park on
+ * a condition variable; submit() wakes one parked worker. An idle pool therefore
+ * uses no CPU, while back-to-back sorts still find spinning workers.
+ *
+ * A thread that waits on a group helps run it: it claims one of CALLER_SLOTS
+ * extra deques, which workers steal from like any other, pops the tasks it
+ * pushes itself and steals only tasks of the group it waits for. A sort on a
+ * pool of N workers thus runs on N + 1 threads.
+ *
+ * The pool only grows (reserve_workers, up to MAX_WORKERS); how many threads a
+ * task tree uses is the concurrency budget of its TaskGroup. Workers check the
+ * budget before they take a task, leave the tasks of a group whose budget is
+ * used up in their deques and park when only such tasks are queued; a thread
+ * giving back the last unit wakes one of them.
+ *
+ * Worker i is placed on the i-th CPU of CpuTopology::placement() (pinned there
+ * if pin_workers is set). Thieves try victims sharing their last-level cache
+ * first, then their NUMA node, then remote ones, so stolen subarrays tend to
+ * stay near the pages they were partitioned on.
  */
 class ThreadPool {
+public:
+    // Failed steal rounds an idle worker spins (yielding) before it parks
+    static constexpr int IDLE_SPIN_ROUNDS = 128;
+    // Threads outside the pool that can help with their own groups at once
+    static constexpr size_t CALLER_SLOTS = 8;
+    // Upper bound of reserve_workers
+    static constexpr size_t MAX_WORKERS = 256;
+
 private:
-    struct WorkStealingQueue {
-        std::deque<std::function<void()>> q;
-        std::mutex mtx; // Protects ONLY this specific queue
+    // Per-worker counters, padded so workers never share a cache line
+    struct alignas(64) WorkerStats {
+        std::atomic<long> tasks_pushed{0};
+        std::atomic<long> tasks_executed{0};
+        std::atomic<long> steal_attempts{0};
+        std::atomic<long> steal_successes{0};
+        std::atomic<long> local_pops{0};
+        std::atomic<long> parks{0};
+        // Odd while the thread reads groups of tasks it has not taken (PeekGuard)
+        std::atomic<unsigned> peek_seq{0};
 
-        // Push a task to the bottom (Owner only)
-        void push(std::function<void()> task) {
-            std::lock_guard<std::mutex> lock(mtx);
-            q.push_back(std::move(task));
+        // Single writer: a relaxed load/store pair avoids a locked instruction
+        static void bump(std::atomic<long>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
         }
+    };
 
-        // Pop from bottom (Owner only)
-        bool try_pop(std::function<void()>& task) {
-            std::lock_guard<std::mutex> lock(mtx);
-            if (q.empty()) return false;
-            task = std::move(q.back()); // LIFO
-            q.pop_back();
-            return true;
+    static constexpr size_t NUM_SLOTS = MAX_WORKERS + CALLER_SLOTS;
+
+    // Slot i < MAX_WORKERS is worker i (created by reserve_workers), the last
+    // CALLER_SLOTS slots belong to helping callers. The arrays never move, so
+    // workers can scan them while the pool grows.
+    std::unique_ptr<std::unique_ptr<WorkStealingDeque>[]> queues;
+    std::unique_ptr<WorkerStats[]> stats;
+    std::unique_ptr<std::atomic<bool>[]> caller_slot_taken;
+    std::atomic<size_t> worker_count{0};
+    std::mutex grow_mutex;
+    const std::vector<CpuInfo> placement;
+    const bool pin_workers;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stop{false};
+
+    // Group of plain submit() calls from outside the pool (wait_for_completion)
+    TaskGroup default_group{0, nullptr, nullptr};
+
+    // Tasks submitted by threads that are not workers of this pool
+    std::mutex inject_mutex;
+    std::deque<Task> injected;
+    std::atomic<long> injected_count{0};
+    std::atomic<long> external_pushed{0};
+
+    // Parking of idle workers. A worker registers in 'sleepers' before its final
+    // scan for work and submit() checks 'sleepers' after publishing a task (both
+    // behind seq_cst fences), so either the worker sees the task or the submitter
+    // sees the sleeper and bumps 'wake_epoch' under park_mutex.
+    std::mutex park_mutex;
+    std::condition_variable park_cv;
+    std::atomic<std::uint64_t> wake_epoch{0};
+    std::atomic<int> sleepers{0};
+
+    // Pool the current thread works for (nullptr for external threads)
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    // Group of the task the current thread is running (inherited by submit)
+    static inline thread_local TaskGroup* current_group = nullptr;
+
+    static bool is_caller_slot(size_t slot) { return slot >= MAX_WORKERS; }
+
+    // Position of a slot in the stealing ring: workers first, then caller slots
+    static size_t ring_position(size_t slot, size_t count) {
+        return is_caller_slot(slot) ? count + (slot - MAX_WORKERS) : slot;
+    }
+
+    static size_t ring_slot(size_t position, size_t count) {
+        return position < count ? position : MAX_WORKERS + (position - count);
+    }
+
+    // Takes the oldest injected task the predicate accepts
+    template<typename Predicate>
+    bool try_take_injected(Task& task, Predicate accept) {
+        if (injected_count.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> lock(inject_mutex);
+        auto it = std::find_if(injected.begin(), injected.end(), accept);
+        if (it == injected.end()) return false;
+        task = *it;
+        injected.erase(it);
+        injected_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const CpuInfo& home_cpu(size_t worker) const { return placement[worker % placement.size()]; }
+
+    // Steal order of a slot: other workers by topology distance (nearest first,
+    // ring order within a tier), then the caller slots. Helping callers do not
+    // know their CPU and use plain ring order.
+    void build_victims(size_t slot, size_t count, std::vector<size_t>& victims) const {
+        victims.clear();
+        size_t self = is_caller_slot(slot) ? count : slot;
+        for (size_t offset = 1; offset <= count; ++offset) {
+            size_t victim = (self + offset) % (count + 1);
+            if (victim < count && victim != slot) victims.push_back(victim);
+        }
+        if (!is_caller_slot(slot)) {
+            const CpuInfo& home = home_cpu(slot);
+            std::stable_sort(victims.begin(), victims.end(), [&](size_t x, size_t y) {
+                return CpuTopology::distance(home, home_cpu(x)) < CpuTopology::distance(home, home_cpu(y));
+            });
+        }
+        for (size_t s = 0; s < CALLER_SLOTS; ++s) {
+            if (MAX_WORKERS + s != slot) victims.push_back(MAX_WORKERS + s);
         }
+    }
 
-        // Steal from top (Thieves only)
-        bool try_steal(std::function<void()>& task) {
-            // CRITICAL: Use try_lock to avoid blocking on contention
-            std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
-            if (!lock || q.empty()) return false;
-            task = std::move(q.front()); // FIFO
-            q.pop_front();
-            return true;
+    // Steal order of the calling thread, rebuilt when the pool has grown
+    const std::vector<size_t>& victims_of(size_t slot) {
+        thread_local std::vector<size_t> victims;
+        thread_local const ThreadPool* built_by = nullptr;
+        thread_local size_t built_slot = 0;
+        thread_local size_t built_count = 0;
+        size_t count = worker_count.load(std::memory_order_acquire);
+        if (built_by != this || built_slot != slot || built_count != count) {
+            build_victims(slot, count, victims);
+            built_by = this;
+            built_slot = slot;
+            built_count = count;
         }
+        return victims;
+    }
 
-        bool empty() {
-            std::lock_guard<std::mutex> lock(mtx);
-            return q.empty();
+    // Marks a thread reading the group of a task that another thread may take,
+    // run and whose group it may destroy meanwhile. wait() does not return
+    // while a guard that was open when the group finished is still open, so
+    // the group outlives every such read.
+    class PeekGuard {
+    public:
+        explicit PeekGuard(WorkerStats& own) : seq(own.peek_seq) {
+            seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
         }
+        ~PeekGuard() { seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+        PeekGuard(const PeekGuard&) = delete;
+        PeekGuard& operator=(const PeekGuard&) = delete;
+
+    private:
+        std::atomic<unsigned>& seq;
     };
 
-    std::vector<std::unique_ptr<WorkStealingQueue>> queues;
-    std::vector<std::thread> workers;
-    std::atomic<bool> stop{false};
-    std::atomic<long> incomplete_tasks{0};
+    // Called by wait() once the group is done (see PeekGuard)
+    void wait_for_peeks() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for_each_slot([this](size_t slot) {
+            const std::atomic<unsigned>& seq = stats[slot].peek_seq;
+            unsigned open = seq.load(std::memory_order_acquire);
+            if (open % 2 == 0) return;
+            while (seq.load(std::memory_order_acquire) == open) {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    // Takes a task through 'take' (a try_pop_if or try_steal_if of some deque)
+    // only if its group has budget left, and enters that group
+    template<typename Take>
+    bool take_runnable(WorkerStats& own, Take take) {
+        PeekGuard guard(own);
+        TaskGroup* entered = nullptr;
+        bool taken = take([&entered](const Task& t) {
+            if (!t.get_group()->try_enter()) return false;
+            entered = t.get_group();
+            return true;
+        });
+        // Lost the task to another thread after entering its group
+        if (!taken && entered != nullptr) release(*entered);
+        return taken;
+    }
+
+    // Gives back a budget unit; when the budget was used up, idle workers may
+    // have parked over the group's tasks, so one is woken to take them
+    void release(TaskGroup& group) {
+        if (group.leave()) wake_one();
+    }
+
+    // One steal round over all other deques. Workers (group == nullptr) take any
+    // task whose group has budget left and enter that group; helpers only take
+    // tasks of their own group.
+    bool try_steal_task(size_t thief, Task& task, TaskGroup* group = nullptr) {
+        WorkerStats& own = stats[thief];
+        WorkerStats::bump(own.steal_attempts);
+        for (size_t slot : victims_of(thief)) {
+            WorkStealingDeque& victim = *queues[slot];
+            if (victim.empty()) continue;
+
+            bool stolen;
+            if (group != nullptr) {
+                stolen = victim.try_steal_if(task, [group](const Task& t) { return t.get_group() == group; });
+            } else {
+                stolen = take_runnable(own, [&](auto accept) { return victim.try_steal_if(task, accept); });
+            }
+            if (stolen) {
+                WorkerStats::bump(own.steal_successes);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Whether worker 'slot' could take a task: its own newest one, the oldest
+    // of any deque or an injected one, whose group has budget left
+    bool has_work(size_t slot) {
+        auto runnable = [](const Task& t) { return t.get_group()->has_budget(); };
+        if (injected_count.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            if (std::any_of(injected.begin(), injected.end(), runnable)) return true;
+        }
+        PeekGuard guard(stats[slot]);
+        if (queues[slot]->newest_satisfies(runnable)) return true;
+        size_t count = worker_count.load(std::memory_order_acquire);
+        for (size_t position = 0; position < count + CALLER_SLOTS; ++position) {
+            if (queues[ring_slot(position, count)]->oldest_satisfies(runnable)) return true;
+        }
+        return false;
+    }
+
+    void park(size_t slot) {
+        WorkerStats& own = stats[slot];
+        std::uint64_t epoch = wake_epoch.load(std::memory_order_acquire);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Final scan: a task published (or a unit freed) before we registered is visible now
+        if (!has_work(slot) && !stop.load(std::memory_order_relaxed)) {
+            WorkerStats::bump(own.parks);
+            std::unique_lock<std::mutex> lock(park_mutex);
+            park_cv.wait(lock, [&] {
+                return stop.load(std::memory_order_relaxed) || wake_epoch.load(std::memory_order_relaxed) != epoch;
+            });
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wake_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(park_mutex);
+                wake_epoch.fetch_add(1, std::memory_order_relaxed);
+            }
+            park_cv.notify_one();
+        }
+    }
+
+    // Runs a task; 'counted' tasks hold a budget unit of their group, released here.
+    // Tasks of a cancelled group are dropped, and an exception a task throws is
+    // kept in its group for wait(), so the thread goes on with the next task.
+    void run_task(Task& task, WorkerStats& own, bool counted) {
+        TaskGroup* group = task.get_group();
+        if (group->cancelled()) {
+            task.discard();
+        } else {
+            TaskGroup* outer = current_group;
+            current_group = group;
+            SortStopScope stop_scope(group->stop);
+            try {
+                task();
+            } catch (...) {
+                group->capture_exception(std::current_exception());
+            }
+            current_group = outer;
+        }
+
+        WorkerStats::bump(own.tasks_executed);
+        if (counted) release(*group);
+        group->finish();
+    }
+
+    void worker_loop(size_t i) {
+        thread_index = static_cast<int>(i);
+        current_pool = this;
+        if (pin_workers) {
+            pin_current_thread(home_cpu(i).cpu);
+        }
+        WorkStealingDeque& own_queue = *queues[i];
+        WorkerStats& own = stats[i];
+        int idle_rounds = 0;
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            Task task;
+            bool found = false;
+
+            // 1. Try Local Pop (LIFO), or the oldest local task when the newest
+            // one's group has no budget left (it stays for the group's threads)
+            if (take_runnable(own, [&](auto accept) { return own_queue.try_pop_if(task, accept); }) ||
+                take_runnable(own, [&](auto accept) { return own_queue.try_steal_if(task, accept); })) {
+                found = true;
+                WorkerStats::bump(own.local_pops);
+            }
+            // 2. Take work submitted from outside the pool
+            if (!found) {
+                found = try_take_injected(task, [](const Task& t) { return t.get_group()->try_enter(); });
+            }
+            // 3. Try Steal (FIFO)
+            if (!found) {
+                found = try_steal_task(i, task);
+            }
+
+            if (found) {
+                idle_rounds = 0;
+                run_task(task, own, true);
+            } else if (++idle_rounds < IDLE_SPIN_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                idle_rounds = 0;
+                park(i);
+            }
+        }
+    }
+
+    // Runs tasks of 'group' on the calling thread, which owns deque 'slot'.
+    // Returns when the group is done or no task of it was found for a while.
+    // The caller holds one budget unit of the group, so its tasks are not counted.
+    void help(TaskGroup& group, size_t slot) {
+        WorkerStats& own = stats[slot];
+        int idle_rounds = 0;
+        auto in_group = [&group](const Task& t) { return t.get_group() == &group; };
+
+        while (!group.done()) {
+            Task task;
+            bool found = false;
+
+            // Own deque first, as long as its newest task belongs to the group (a
+            // worker waiting inside a task may have older tasks of its own tree there)
+            if (queues[slot]->try_pop_if(task, in_group)) {
+                found = true;
+                WorkerStats::bump(own.local_pops);
+            }
+            if (!found) {
+                found = try_take_injected(task, in_group) ||
+                        try_steal_task(slot, task, &group);
+            }
 
-    // For wait_for_completion
-    std::mutex wait_mutex;
-    std::condition_variable wait_cv;
+            if (found) {
+                idle_rounds = 0;
+                run_task(task, own, false);
+            } else if (++idle_rounds < IDLE_SPIN_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                return;
+            }
+        }
+    }
 
-    // Profiling
-    std::atomic<long> tasks_pushed{0};
-    std::atomic<long> tasks_executed{0};
-    std::atomic<long> steal_attempts{0};
-    std::atomic<long> steal_successes{0};
-    std::atomic<long> local_pops{0};
+    // Claims a free caller deque for an external thread, -1 if all are in use
+    int acquire_caller_slot() {
+        for (size_t s = 0; s < CALLER_SLOTS; ++s) {
+            if (!caller_slot_taken[s].load(std::memory_order_relaxed) &&
+                !caller_slot_taken[s].exchange(true, std::memory_order_acquire)) {
+                return static_cast<int>(MAX_WORKERS + s);
+            }
+        }
+        return -1;
+    }
+
+    void release_caller_slot(int slot) {
+        caller_slot_taken[slot - MAX_WORKERS].store(false, std::memory_order_release);
+    }
+
+    // Helps with 'group' from 'slot', holding one budget unit meanwhile. With
+    // the budget used up by workers, the caller just blocks. A thread running
+    // a task of the same budget already holds its unit.
+    void help_counted(TaskGroup& group, size_t slot) {
+        if (current_group != nullptr && current_group->shares_budget_with(group)) {
+            help(group, slot);
+            return;
+        }
+        if (!group.try_enter()) return;
+        help(group, slot);
+        release(group);
+    }
+
+    // Created deques in ring order (workers, then caller slots)
+    template<typename Visitor>
+    void for_each_slot(Visitor visit) const {
+        size_t count = worker_count.load(std::memory_order_acquire);
+        for (size_t position = 0; position < count + CALLER_SLOTS; ++position) {
+            visit(ring_slot(position, count));
+        }
+    }
 
 public:
     void reset_stats() {
-        tasks_pushed = 0;
-        tasks_executed = 0;
-        steal_attempts = 0;
-        steal_successes = 0;
-        local_pops = 0;
-    }
-
-    long get_tasks_pushed() const { return tasks_pushed; }
-    long get_tasks_executed() const { return tasks_executed; }
-    long get_steal_attempts() const { return steal_attempts; }
-    long get_steal_successes() const { return steal_successes; }
-    long get_local_pops() const { return local_pops; }
-    size_t get_thread_count() const { return workers.size(); }
-
-    ThreadPool(size_t num_threads = std::thread::hardware_concurrency()) {
-        queues.reserve(num_threads);
-        for (size_t i = 0; i < num_threads; ++i) {
-            queues.push_back(std::make_unique<WorkStealingQueue>());
-        }
-
-        for (size_t i = 0; i < num_threads; ++i) {
-            workers.emplace_back([this, i, num_threads] {
-                thread_index = static_cast<int>(i);
-
-                while (!stop) {
-                    std::function<void()> task;
-                    bool found = false;
-
-                    // 1. Try Local Pop (LIFO)
-                    if (queues[i]->try_pop(task)) {
-                        found = true;
-                        local_pops++;
-                    }
-                    // 2. Try Steal (FIFO)
-                    else {
-                        steal_attempts++;
-                        // Random victim selection strategy
-                        for (size_t offset = 1; offset < num_threads; ++offset) {
-                            size_t victim = (i + offset) % num_threads;
-                            if (queues[victim]->try_steal(task)) {
-                                found = true;
-                                steal_successes++;
-                                break;
-                            }
-                        }
-                    }
-
-                    if (found) {
-                        try {
-                            task();
-                        } catch (...) {
-                            // Ensure incomplete_tasks is decremented even if task throws
-                            long remaining = --incomplete_tasks;
-                            if (remaining == 0) {
-                                wait_cv.notify_all();
-                            }
-                            throw;
-                        }
-
-                        tasks_executed++;
-                        long remaining = --incomplete_tasks;
-                        if (remaining == 0) {
-                             wait_cv.notify_all();
-                        }
-                    } else {
-                        std::this_thread::yield();
-                    }
-                }
-            });
+        for_each_slot([this](size_t slot) {
+            stats[slot].tasks_pushed = 0;
+            stats[slot].tasks_executed = 0;
+            stats[slot].steal_attempts = 0;
+            stats[slot].steal_successes = 0;
+            stats[slot].local_pops = 0;
+            stats[slot].parks = 0;
+        });
+        external_pushed = 0;
+    }
+
+    /// Slots worker i steals from, nearest first (workers below MAX_WORKERS, then caller slots)
+    std::vector<size_t> get_steal_order(size_t worker) const {
+        std::vector<size_t> victims;
+        build_victims(worker, worker_count.load(std::memory_order_acquire), victims);
+        return victims;
+    }
+
+    /// Group of the task the calling thread is running in any pool (nullptr outside tasks)
+    static TaskGroup* current_task_group() { return current_group; }
+
+    /// Whether the group of the running task has been cancelled; long tasks poll it to stop early
+    static bool cancellation_requested() {
+        return current_group != nullptr && current_group->cancelled();
+    }
+
+    /// CPU worker i is placed on
+    CpuInfo get_worker_cpu(size_t worker) const { return home_cpu(worker); }
+
+    long get_tasks_pushed() const { return external_pushed + sum(&WorkerStats::tasks_pushed); }
+    long get_tasks_executed() const { return sum(&WorkerStats::tasks_executed); }
+    long get_steal_attempts() const { return sum(&WorkerStats::steal_attempts); }
+    long get_steal_successes() const { return sum(&WorkerStats::steal_successes); }
+    long get_local_pops() const { return sum(&WorkerStats::local_pops); }
+    long get_parks() const { return sum(&WorkerStats::parks); }
+    int get_parked_threads() const { return sleepers.load(std::memory_order_relaxed); }
+    size_t get_thread_count() const { return worker_count.load(std::memory_order_acquire); }
+
+    /**
+     * @param num_threads Initial number of workers
+     * @param pin_workers Bind worker i to the i-th CPU of the topology's placement()
+     * @param topology Machine layout used for placement and victim order
+     */
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency(), bool pin_workers = false,
+                        const CpuTopology& topology = CpuTopology::system())
+        : queues(new std::unique_ptr<WorkStealingDeque>[NUM_SLOTS]),
+          stats(new WorkerStats[NUM_SLOTS]),
+          caller_slot_taken(new std::atomic<bool>[CALLER_SLOTS]),
+          placement(topology.placement().empty() ? std::vector<CpuInfo>(1) : topology.placement()),
+          pin_workers(pin_workers) {
+        for (size_t s = 0; s < CALLER_SLOTS; ++s) {
+            caller_slot_taken[s].store(false, std::memory_order_relaxed);
+            queues[MAX_WORKERS + s] = std::make_unique<WorkStealingDeque>();
         }
+        reserve_workers(num_threads == 0 ? 1 : num_threads);
     }
 
     ~ThreadPool() {
-        stop = true;
+        {
+            std::lock_guard<std::mutex> lock(park_mutex);
+            stop = true;
+        }
+        park_cv.notify_all();
+        std::lock_guard<std::mutex> lock(grow_mutex);
         for (auto& worker : workers) {
             if (worker.joinable()) worker.join();
         }
     }
 
-    template<typename F>
-    void submit(F&& f) {
-        incomplete_tasks++;
-        int idx = thread_index;
-        if (idx == -1) idx = 0;
-        if (idx >= static_cast<int>(queues.size())) idx = 0;
+    /**
+     * @brief Grows the pool to at least num_threads workers (at most MAX_WORKERS).
+     *
+     * Workers are never removed, so this is free once the pool is large enough
+     * and safe while other threads submit and wait.
+     */
+    void reserve_workers(size_t num_threads) {
+        num_threads = std::min(num_threads, MAX_WORKERS);
+        if (worker_count.load(std::memory_order_acquire) >= num_threads) return;
 
-        queues[idx]->push(std::forward<F>(f));
-        tasks_pushed++;
+        std::lock_guard<std::mutex> lock(grow_mutex);
+        for (size_t i = worker_count.load(std::memory_order_relaxed); i < num_threads; ++i) {
+            queues[i] = std::make_unique<WorkStealingDeque>();
+            // Publish the deque before any thread can steal from or run on it
+            worker_count.store(i + 1, std::memory_order_release);
+            workers.emplace_back([this, i] { worker_loop(i); });
+        }
     }
 
-    void wait_for_completion() {
-        while (true) {
-            if (incomplete_tasks == 0) {
-                return;
+    /**
+     * @brief Submits a task to the given group.
+     */
+    template<typename F>
+    void submit(TaskGroup& group, F&& f) {
+        Task task(std::forward<F>(f), &group);
+        group.add();
+
+        try {
+            if (current_pool == this) {
+                // Worker of this pool: lock-free push to its own deque
+                queues[thread_index]->push(task);
+                WorkerStats::bump(stats[thread_index].tasks_pushed);
+            } else {
+                std::lock_guard<std::mutex> lock(inject_mutex);
+                injected.push_back(task);
+                injected_count.fetch_add(1, std::memory_order_release);
+                external_pushed.fetch_add(1, std::memory_order_relaxed);
             }
+        } catch (...) {
+            // Out of memory for the queue: the task was never submitted
+            task.discard();
+            group.finish();
+            throw;
+        }
+        // A group without budget left runs the task itself; release() wakes a worker later
+        if (group.has_budget()) wake_one();
+    }
 
-            // DISABLE HELPING for Main Thread to avoid "Queue 0 Bottleneck"
-            // If Main Thread helps, it executes tasks with thread_index = -1,
-            // pushing sub-tasks to Queue 0, causing centralization.
+    /**
+     * @brief Submits a task to the group of the running task.
+     *
+     * Called from inside a task, the new task joins that task's group; called
+     * from any other thread, it joins the pool's default group.
+     */
+    template<typename F>
+    void submit(F&& f) {
+        TaskGroup* group = (current_pool == this && current_group != nullptr) ? current_group : &default_group;
+        submit(*group, std::forward<F>(f));
+    }
 
-            std::unique_lock<std::mutex> lock(wait_mutex);
-            wait_cv.wait_for(lock, std::chrono::microseconds(100));
+    /**
+     * @brief Runs tasks of the group on the calling thread until all have finished.
+     *
+     * The caller helps through a caller slot (or its own deque when it is a
+     * worker of this pool) and blocks on the group once it finds nothing left
+     * to steal, so it never sleeps while its own tasks are queued. While it
+     * helps, it uses one unit of the group's budget (and only helps if one is free).
+     *
+     * Rethrows the first exception a task of the group threw, after all tasks
+     * have finished; the group can then be used again.
+     */
+    void wait(TaskGroup& group) {
+        if (!group.done()) {
+            if (current_pool == this) {
+                help_counted(group, static_cast<size_t>(thread_index));
+            } else {
+                int slot = acquire_caller_slot();
+                if (slot >= 0) {
+                    ThreadPool* outer_pool = current_pool;
+                    int outer_index = thread_index;
+                    current_pool = this;
+                    thread_index = slot;
+                    help_counted(group, static_cast<size_t>(slot));
+                    current_pool = outer_pool;
+                    thread_index = outer_index;
+                    release_caller_slot(slot);
+                }
+            }
         }
+        // Still through the lock when done: the last task may not have released it yet
+        group.block_until_done();
+        // The caller may destroy the group once this returns
+        wait_for_peeks();
+        group.rethrow_if_failed();
+    }
+
+    /**
+     * @brief Blocks until every task of the default group has finished.
+     */
+    void wait_for_completion() {
+        wait(default_group);
+    }
+
+private:
+    long sum(std::atomic<long> WorkerStats::* counter) const {
+        long total = 0;
+        for_each_slot([&](size_t slot) {
+            total += (stats[slot].*counter).load(std::memory_order_relaxed);
+        });
+        return total;
     }
 };
 
-// Singleton accessor with re-initialization support
-inline std::unique_ptr<ThreadPool>& getThreadPoolInstance() {
-    static std::unique_ptr<ThreadPool> pool;
-    return pool;
+/**
+ * @brief Whether the shared pool pins its workers (environment variable DPQS_PIN_THREADS=1).
+ */
+inline bool pin_threads_requested() {
+    const char* value = std::getenv("DPQS_PIN_THREADS");
+    return value != nullptr && *value != '\0' && *value != '0';
+}
+
+// Defined after ThreadPool: a group created inside a task takes that task's group as parent
+inline TaskGroup::TaskGroup(int max_threads)
+    : TaskGroup(max_threads, ThreadPool::current_task_group(), sort_stop_slot()) {}
+
+inline TaskGroup::TaskGroup(inherit_budget_t)
+    : TaskGroup(0, ThreadPool::current_task_group(), sort_stop_slot(),
+                ThreadPool::current_task_group() != nullptr ? ThreadPool::current_task_group()->budget : nullptr) {}
+
+/**
+ * @brief Number of threads the tasks of 'group' may use: its budget, or the
+ * whole pool plus the caller when unlimited.
+ */
+inline std::ptrdiff_t concurrency_budget(const ThreadPool& pool, const TaskGroup& group) {
+    return group.max_threads() > 0 ? group.max_threads() : static_cast<std::ptrdiff_t>(pool.get_thread_count()) + 1;
+}
+
+/**
+ * @brief Number of threads the running sort may use: the budget of its task
+ * group, or the whole pool plus the caller outside of tasks.
+ */
+inline std::ptrdiff_t concurrency_budget(const ThreadPool& pool) {
+    TaskGroup* group = ThreadPool::current_task_group();
+    return group != nullptr ? concurrency_budget(pool, *group) : static_cast<std::ptrdiff_t>(pool.get_thread_count()) + 1;
 }
 
+/**
+ * @brief Process-wide pool shared by all parallel sorts.
+ *
+ * The pool is created on first use and only grows: a request for more workers
+ * than it has adds threads, any other request returns it unchanged. Callers
+ * limit their own parallelism through the budget of their TaskGroup.
+ *
+ * @param num_threads Minimum number of workers (0: hardware concurrency on first use)
+ */
 inline ThreadPool& getThreadPool(int num_threads = 0) {
-    auto& pool = getThreadPoolInstance();
-    if (!pool) {
-        pool = std::make_unique<ThreadPool>(num_threads > 0 ? num_threads : std::thread::hardware_concurrency());
-    } else if (num_threads > 0 && pool->get_thread_count() != static_cast<size_t>(num_threads)) {
-        pool = std::make_unique<ThreadPool>(num_threads);
+    static ThreadPool pool(num_threads > 0 ? static_cast<size_t>(num_threads) : std::thread::hardware_concurrency(),
+                           pin_threads_requested());
+    if (num_threads > 0) {
+        pool.reserve_workers(static_cast<size_t>(num_threads));
     }
-    return *pool;
+    return pool;
 }
 
 } // namespace dual_pivot
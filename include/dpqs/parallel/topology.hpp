@@ -0,0 +1,218 @@
+#ifndef DPQS_PARALLEL_TOPOLOGY_HPP
+#define DPQS_PARALLEL_TOPOLOGY_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <tuple>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace dual_pivot {
+
+/**
+ * @brief Location of one logical CPU.
+ */
+struct CpuInfo {
+    int cpu = 0;      ///< Logical CPU number
+    int package = 0;  ///< Physical package (socket)
+    int node = 0;     ///< NUMA node
+    int llc = 0;      ///< Id of the last-level cache the CPU shares
+};
+
+/**
+ * @brief Distance between two CPUs as seen by a work-stealing thief.
+ */
+enum class CpuDistance {
+    SameCache = 0,  ///< Share the last-level cache
+    SameNode = 1,   ///< Same NUMA node, different cache
+    Remote = 2      ///< Different NUMA node
+};
+
+/**
+ * @brief Parses a kernel CPU list such as "0-3,8,10-11".
+ */
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> result;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty() || item == "\n") continue;
+        std::size_t dash = item.find('-');
+        try {
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+        } catch (...) {
+            // Ignore malformed entries
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief CPU, cache and NUMA layout of the machine.
+ *
+ * Read from the Linux sysfs tree (/sys/devices/system). Missing files fall back
+ * to a single package, node and cache, so on other systems every CPU is at
+ * distance SameCache from every other and the topology is a no-op.
+ */
+class CpuTopology {
+private:
+    std::vector<CpuInfo> cpu_list;
+
+    static bool read_line(const std::string& path, std::string& line) {
+        std::ifstream file(path);
+        return file && std::getline(file, line);
+    }
+
+    static int read_int(const std::string& path, int fallback) {
+        std::string line;
+        if (!read_line(path, line)) return fallback;
+        try {
+            return std::stoi(line);
+        } catch (...) {
+            return fallback;
+        }
+    }
+
+    // Id of the last-level cache: the highest cache index that exists. Older
+    // kernels have no "id" file, then the first CPU sharing the cache names it.
+    static int read_llc(const std::string& cpu_dir, int cpu) {
+        for (int index = 4; index >= 0; --index) {
+            std::string cache_dir = cpu_dir + "/cache/index" + std::to_string(index);
+            std::string line;
+            if (!read_line(cache_dir + "/shared_cpu_list", line)) continue;
+            int id = read_int(cache_dir + "/id", -1);
+            if (id >= 0) return id;
+            std::vector<int> shared = parse_cpu_list(line);
+            return shared.empty() ? cpu : shared.front();
+        }
+        return 0;
+    }
+
+public:
+    CpuTopology() = default;
+
+    explicit CpuTopology(std::vector<CpuInfo> cpus) : cpu_list(std::move(cpus)) {}
+
+    /**
+     * @brief Reads the topology below a sysfs root (normally /sys/devices/system).
+     */
+    static CpuTopology from_sysfs(const std::string& root) {
+        std::string line;
+        std::vector<int> online;
+        if (read_line(root + "/cpu/online", line)) {
+            online = parse_cpu_list(line);
+        }
+
+        std::vector<CpuInfo> cpus;
+        for (int cpu : online) {
+            std::string cpu_dir = root + "/cpu/cpu" + std::to_string(cpu);
+            CpuInfo info;
+            info.cpu = cpu;
+            info.package = read_int(cpu_dir + "/topology/physical_package_id", 0);
+            info.llc = read_llc(cpu_dir, cpu);
+            cpus.push_back(info);
+        }
+
+        // NUMA membership is listed per node
+        std::vector<int> nodes;
+        if (read_line(root + "/node/online", line)) {
+            nodes = parse_cpu_list(line);
+        }
+        for (int node : nodes) {
+            if (!read_line(root + "/node/node" + std::to_string(node) + "/cpulist", line)) continue;
+            for (int cpu : parse_cpu_list(line)) {
+                for (auto& info : cpus) {
+                    if (info.cpu == cpu) info.node = node;
+                }
+            }
+        }
+        return CpuTopology(std::move(cpus));
+    }
+
+    /**
+     * @brief Topology of the running machine, read once.
+     */
+    static const CpuTopology& system() {
+        static const CpuTopology topology = [] {
+            CpuTopology parsed = from_sysfs("/sys/devices/system");
+            if (parsed.cpu_list.empty()) {
+                // No sysfs: one flat domain of hardware_concurrency CPUs
+                unsigned count = std::max(1u, std::thread::hardware_concurrency());
+                for (unsigned cpu = 0; cpu < count; ++cpu) {
+                    CpuInfo info;
+                    info.cpu = static_cast<int>(cpu);
+                    parsed.cpu_list.push_back(info);
+                }
+            }
+            return parsed;
+        }();
+        return topology;
+    }
+
+    const std::vector<CpuInfo>& cpus() const { return cpu_list; }
+
+    std::size_t node_count() const {
+        std::vector<int> nodes;
+        for (const auto& info : cpu_list) nodes.push_back(info.node);
+        std::sort(nodes.begin(), nodes.end());
+        return static_cast<std::size_t>(std::unique(nodes.begin(), nodes.end()) - nodes.begin());
+    }
+
+    /**
+     * @brief CPUs in worker placement order.
+     *
+     * Grouped by node, then package and cache, so consecutive workers share a
+     * cache and the first workers of a small pool stay on one socket.
+     */
+    std::vector<CpuInfo> placement() const {
+        // Sorted through indices: dual_pivot::swap would make swapping CpuInfo ambiguous
+        std::vector<std::size_t> index(cpu_list.size());
+        for (std::size_t i = 0; i < index.size(); ++i) index[i] = i;
+        std::sort(index.begin(), index.end(), [this](std::size_t i, std::size_t j) {
+            const CpuInfo& x = cpu_list[i];
+            const CpuInfo& y = cpu_list[j];
+            return std::tie(x.node, x.package, x.llc, x.cpu) < std::tie(y.node, y.package, y.llc, y.cpu);
+        });
+        std::vector<CpuInfo> order;
+        order.reserve(index.size());
+        for (std::size_t i : index) order.push_back(cpu_list[i]);
+        return order;
+    }
+
+    static CpuDistance distance(const CpuInfo& x, const CpuInfo& y) {
+        if (x.node != y.node) return CpuDistance::Remote;
+        if (x.package != y.package || x.llc != y.llc) return CpuDistance::SameNode;
+        return CpuDistance::SameCache;
+    }
+};
+
+/**
+ * @brief Binds the calling thread to one CPU.
+ *
+ * @return false if pinning is unsupported or was refused (e.g. by a cpuset)
+ */
+inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_PARALLEL_TOPOLOGY_HPP
@@ -2,7 +2,11 @@
 #define DPQS_PARTITION_HPP
 
 #include <utility>
+#include <algorithm>
+#include <cstdint>
 #include "dpqs/utils.hpp"
+#include "dpqs/constants.hpp"
+#include "dpqs/simd_partition.hpp"
 
 namespace dual_pivot {
 
@@ -81,6 +85,191 @@ DPQS_FORCE_INLINE std::pair<std::ptrdiff_t, std::ptrdiff_t> partition_dual_pivot
     return std::make_pair(lt, gt);
 }
 
+/**
+ * @brief Portable block classifier used by partition_dual_pivot_block.
+ *
+ * Each pass writes the offset of every element unconditionally and advances the
+ * write cursor by the comparison result, so the loops contain no conditional jumps.
+ * The offset buffer is indexed by block position, so blocks must not exceed 256.
+ */
+struct ScalarBlockClassifier {
+    // Offsets of the elements that are not greater than the pivot
+    template<typename T, typename Compare>
+    static int not_greater(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare comp) {
+        int count = 0;
+        for (int j = 0; j < n; ++j) {
+            offsets[count] = static_cast<std::uint8_t>(j);
+            count += !comp(pivot, block[j]);
+        }
+        return count;
+    }
+
+    // Offsets of the elements that are less than the pivot
+    template<typename T, typename Compare>
+    static int less(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare comp) {
+        int count = 0;
+        for (int j = 0; j < n; ++j) {
+            offsets[count] = static_cast<std::uint8_t>(j);
+            count += comp(block[j], pivot);
+        }
+        return count;
+    }
+};
+
+/**
+ * @brief Branchless block dual-pivot partitioning (BlockQuicksort style)
+ *
+ * Produces exactly the same layout and return value as partition_dual_pivot, but
+ * avoids the two data-dependent branches per element that the classic scheme takes.
+ * On random input those branches mispredict roughly every other element, which
+ * costs more than the comparisons themselves for cheap keys.
+ *
+ * Following Edelkamp and Weiss ("BlockQuicksort: Avoiding Branch Mispredictions in
+ * Quicksort"), the comparison results are first buffered as offsets into a small
+ * block, and the element moves are then driven by the offset buffer:
+ *
+ * Invariant while scanning [k, high - 1):
+ * [P1] [elements < P1] [P1 <= elements <= P2] [elements > P2] [unscanned] [P2]
+ *       ↑               ↑                      ↑               ↑
+ *      low+1            lt                     gt              k
+ *
+ * For each block of BLOCK_PARTITION_SIZE elements:
+ * 1. Record the offsets of all elements that are not greater than P2 and move
+ *    them Lomuto-style to the front of the "> P2" region.
+ * 2. Among the elements just moved, record the offsets of those less than P1 and
+ *    move them Lomuto-style to the front of the middle region.
+ *
+ * The classification passes are delegated to a Classifier (ScalarBlockClassifier,
+ * or one of the SIMD classifiers from simd_partition.hpp); the element moves are
+ * shared by all of them.
+ *
+ * @tparam T Element type (trivially copyable types benefit the most)
+ * @tparam Classifier Block classification kernel
+ * @param a Pointer to the array to partition
+ * @param low Starting index of the region to partition
+ * @param high Ending index of the region to partition (exclusive)
+ * @param pivotIndex1 Index of the first pivot element (P1)
+ * @param pivotIndex2 Index of the second pivot element (P2)
+ * @param comp Comparator instance
+ * @return std::pair<int, int> containing (lower, upper) partition boundaries
+ */
+template<typename T, typename Compare, typename Classifier = ScalarBlockClassifier>
+std::pair<std::ptrdiff_t, std::ptrdiff_t> partition_dual_pivot_block(T* a, std::ptrdiff_t low, std::ptrdiff_t high, std::ptrdiff_t pivotIndex1, std::ptrdiff_t pivotIndex2, Compare comp) {
+    // Move pivots to ends
+    std::swap(a[low], a[pivotIndex1]);
+    std::swap(a[high - 1], a[pivotIndex2]);
+
+    const T pivot1 = a[low];
+    const T pivot2 = a[high - 1];
+
+    // Vector classifiers store whole 8-byte offset groups, hence the slack
+    std::uint8_t offsets[BLOCK_PARTITION_SIZE + 16];
+
+    std::ptrdiff_t lt = low + 1;
+    std::ptrdiff_t gt = low + 1;
+    std::ptrdiff_t k = low + 1;
+    const std::ptrdiff_t end = high - 1;
+
+    while (k < end) {
+        const int block = static_cast<int>(std::min<std::ptrdiff_t>(BLOCK_PARTITION_SIZE, end - k));
+
+        // Pass 1: elements not greater than P2 join the middle region
+        const int count = Classifier::not_greater(a + k, block, pivot2, offsets, comp);
+        const std::ptrdiff_t start = gt;
+        for (int j = 0; j < count; ++j) {
+            std::swap(a[start + j], a[k + offsets[j]]);
+        }
+        gt += count;
+
+        // Pass 2: the newcomers that are less than P1 move on to the left region
+        const int small = Classifier::less(a + start, count, pivot1, offsets, comp);
+        for (int j = 0; j < small; ++j) {
+            std::swap(a[lt + j], a[start + offsets[j]]);
+        }
+        lt += small;
+
+        k += block;
+    }
+
+    --lt;
+    std::swap(a[low], a[lt]);
+    std::swap(a[high - 1], a[gt]);
+
+    return std::make_pair(lt, gt);
+}
+
+/**
+ * @brief Calls f with the fastest block classifier for the element and comparator types.
+ *
+ * 4/8-byte integers, float and double ordered by std::less get a vectorized
+ * classifier, picked by runtime CPU detection (AVX-512, then AVX2), so one
+ * binary runs on every machine of a mixed fleet; everything else gets the
+ * portable ScalarBlockClassifier.
+ */
+template<typename T, typename Compare, typename F>
+DPQS_FORCE_INLINE decltype(auto) with_block_classifier(F&& f) {
+#if DPQS_HAS_X86_SIMD
+    if constexpr (use_simd_partition_v<T, Compare>) {
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                return f(Avx512BlockClassifier{});
+            case SimdLevel::AVX2:
+                return f(Avx2BlockClassifier{});
+            default:
+                break;
+        }
+    }
+#endif
+    return f(ScalarBlockClassifier{});
+}
+
+/**
+ * @brief Selects the dual-pivot partitioning kernel for the element and comparator types.
+ *
+ * - Trivially copyable types with a cheap comparator (see is_cheap_comparator) use
+ *   the block partitioner with the classifier chosen by with_block_classifier.
+ * - Everything else keeps the classic scheme, whose branches are cheaper than
+ *   evaluating an expensive comparator twice per element.
+ */
+template<typename T, typename Compare>
+DPQS_FORCE_INLINE std::pair<std::ptrdiff_t, std::ptrdiff_t> partition_dual_pivot_auto(T* a, std::ptrdiff_t low, std::ptrdiff_t high, std::ptrdiff_t pivotIndex1, std::ptrdiff_t pivotIndex2, Compare comp) {
+    if constexpr (use_simd_partition_v<T, Compare> || use_block_partition_v<T, Compare>) {
+        return with_block_classifier<T, Compare>([&](auto classifier) {
+            return partition_dual_pivot_block<T, Compare, decltype(classifier)>(a, low, high, pivotIndex1, pivotIndex2, comp);
+        });
+    } else {
+        return partition_dual_pivot(a, low, high, pivotIndex1, pivotIndex2, comp);
+    }
+}
+
+/**
+ * @brief Branchless block Lomuto pass: moves the elements that match to the front.
+ *
+ * An element matches if it is less than the pivot (LessThanPivot) or not greater
+ * than it. The relative order of the matching elements is kept. The pivot must
+ * not live inside [low, high), pass a copy.
+ *
+ * @return Index of the first element that does not match
+ */
+template<bool LessThanPivot, typename Classifier, typename T, typename Compare>
+std::ptrdiff_t partition_block_pass(T* a, std::ptrdiff_t low, std::ptrdiff_t high, const T& pivot, Compare comp) {
+    std::uint8_t offsets[BLOCK_PARTITION_SIZE + 16];
+    std::ptrdiff_t split = low;
+
+    for (std::ptrdiff_t k = low; k < high; ) {
+        const int block = static_cast<int>(std::min<std::ptrdiff_t>(BLOCK_PARTITION_SIZE, high - k));
+        const int count = LessThanPivot
+            ? Classifier::less(a + k, block, pivot, offsets, comp)
+            : Classifier::not_greater(a + k, block, pivot, offsets, comp);
+        for (int j = 0; j < count; ++j) {
+            std::swap(a[split + j], a[k + offsets[j]]);
+        }
+        split += count;
+        k += block;
+    }
+    return split;
+}
+
 /**
  * @brief Partitions a range of elements based on a single pivot using a 3-way partitioning scheme.
  *
@@ -0,0 +1,338 @@
+#ifndef DPQS_RADIX_SORT_HPP
+#define DPQS_RADIX_SORT_HPP
+
+#include <array>
+#include <vector>
+#include <memory_resource>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include "dpqs/constants.hpp"
+#include "dpqs/sequential_sorters.hpp"
+#include "dpqs/parallel/buffer_manager.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
+
+namespace dual_pivot {
+
+/**
+ * @brief Whether radix_sort can sort T in its natural (std::less) order.
+ *
+ * 4- and 8-byte integers and float/double. Smaller integers already take
+ * counting_sort.
+ */
+template<typename T>
+inline constexpr bool is_radix_sortable_v =
+    ((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_same_v<T, float> || std::is_same_v<T, double>) &&
+    (sizeof(T) == 4 || sizeof(T) == 8);
+
+/**
+ * @brief Order-preserving map from a key to an unsigned integer of the same size.
+ *
+ * Signed integers flip the sign bit. Floating-point values use the IEEE 754 total
+ * order: negative values have all bits flipped, positive values the sign bit, so
+ * -0.0 sorts before +0.0. Every NaN maps to the largest key and sorts after
+ * +infinity, as in sort_floats.
+ */
+template<typename T>
+struct RadixKey {
+    using type = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+    static constexpr type SIGN_BIT = type(1) << (sizeof(T) * 8 - 1);
+
+    static type of(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (value != value) return std::numeric_limits<type>::max();
+            type bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            return (bits & SIGN_BIT) ? static_cast<type>(~bits) : static_cast<type>(bits | SIGN_BIT);
+        } else if constexpr (std::is_signed_v<T>) {
+            return static_cast<type>(value) ^ SIGN_BIT;
+        } else {
+            return static_cast<type>(value);
+        }
+    }
+
+    static constexpr int DIGITS = static_cast<int>(sizeof(T) * 8) / RADIX_BITS;
+
+    static unsigned digit(T value, int d) {
+        return static_cast<unsigned>((of(value) >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1));
+    }
+};
+
+using RadixHistogram = std::array<std::ptrdiff_t, RADIX_BUCKETS>;
+
+/**
+ * @brief Prefix sums of a histogram, in place.
+ */
+inline void radix_exclusive_sum(RadixHistogram& count) {
+    std::ptrdiff_t sum = 0;
+    for (auto& c : count) {
+        std::ptrdiff_t next = sum + c;
+        c = sum;
+        sum = next;
+    }
+}
+
+/**
+ * @brief Sorts n elements by their digits 0 .. digits - 1 (LSD order).
+ *
+ * One pass counts every digit; each digit that is not the same for all elements
+ * then takes one stable scatter pass, alternating between 'data' and 'scratch'.
+ * Small ranges are sorted by comparison instead.
+ *
+ * @param data The elements, all equal in the digits from 'digits' up
+ * @param scratch Buffer of n elements
+ * @param out Where the sorted elements end up: data or scratch
+ */
+template<typename T>
+void radix_sort_lsd(T* data, T* scratch, std::ptrdiff_t n, int digits, T* out) {
+    using Key = RadixKey<T>;
+    if (digits == 0 || n < MIN_RADIX_LSD_SIZE) {
+        if (out != data) std::copy(data, data + n, out);
+        if (digits > 0 && n > 1) {
+            auto less = [](T x, T y) { return Key::of(x) < Key::of(y); };
+            sort_sequential<T, decltype(less)>(nullptr, out, 0, 0, n, less);
+        }
+        return;
+    }
+
+    std::array<RadixHistogram, Key::DIGITS> counts{};
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        typename Key::type key = Key::of(data[i]);
+        for (int d = 0; d < digits; ++d) {
+            ++counts[d][(key >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+        }
+    }
+
+    T* src = data;
+    T* dst = scratch;
+    for (int d = 0; d < digits; ++d) {
+        RadixHistogram& count = counts[d];
+        if (count[Key::digit(src[0], d)] == n) continue;
+
+        radix_exclusive_sum(count);
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            T x = src[i];
+            dst[count[Key::digit(x, d)]++] = x;
+        }
+        std::swap(src, dst);
+    }
+    if (src != out) std::copy(src, src + n, out);
+}
+
+/**
+ * @brief Bits in which the keys of src[begin, end) differ from 'first'.
+ */
+template<typename T>
+typename RadixKey<T>::type radix_key_diff(const T* src, std::ptrdiff_t begin, std::ptrdiff_t end, typename RadixKey<T>::type first) {
+    typename RadixKey<T>::type bits = 0;
+    for (std::ptrdiff_t i = begin; i < end; ++i) {
+        bits |= RadixKey<T>::of(src[i]) ^ first;
+    }
+    return bits;
+}
+
+/**
+ * @brief Highest digit set in a key difference, -1 if there is none.
+ */
+template<typename T>
+int radix_top_digit(typename RadixKey<T>::type diff) {
+    int top = -1;
+    for (int d = 0; d < RadixKey<T>::DIGITS; ++d) {
+        if ((diff >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)) top = d;
+    }
+    return top;
+}
+
+/**
+ * @brief Sequential radix sort of n elements by their digits 0 .. digits - 1.
+ *
+ * Ranges larger than MAX_RADIX_LSD_SIZE first take one MSD pass on their highest
+ * differing digit, so the LSD passes run on cache-sized buckets instead of
+ * streaming the whole range through memory once per digit.
+ *
+ * @param out Where the sorted elements end up: data or scratch
+ */
+template<typename T>
+void radix_sort_sequential(T* data, T* scratch, std::ptrdiff_t n, int digits, T* out) {
+    using Key = RadixKey<T>;
+    if (n <= MAX_RADIX_LSD_SIZE || digits <= 1) {
+        radix_sort_lsd(data, scratch, n, digits, out);
+        return;
+    }
+
+    typename Key::type mask = (digits == Key::DIGITS) ? ~typename Key::type(0)
+        : static_cast<typename Key::type>((typename Key::type(1) << (digits * RADIX_BITS)) - 1);
+    int top = radix_top_digit<T>(radix_key_diff(data, 0, n, Key::of(data[0])) & mask);
+    if (top < 0) {
+        if (out != data) std::copy(data, data + n, out);
+        return;
+    }
+
+    RadixHistogram count{};
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        ++count[Key::digit(data[i], top)];
+    }
+    radix_exclusive_sum(count);
+    RadixHistogram starts = count;
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        T x = data[i];
+        scratch[count[Key::digit(x, top)]++] = x;
+    }
+
+    T* result = (out == data) ? data : scratch;
+    for (std::size_t b = 0; b < RADIX_BUCKETS; ++b) {
+        std::ptrdiff_t begin = starts[b];
+        std::ptrdiff_t length = count[b] - begin;
+        if (length > 0) {
+            radix_sort_sequential(scratch + begin, data + begin, length, top, result + begin);
+        }
+    }
+}
+
+/**
+ * @brief Highest digit in which two of the n elements differ, -1 if all keys are equal.
+ */
+template<typename T>
+int radix_top_digit(const T* src, std::ptrdiff_t n, ThreadPool& pool, int threads) {
+    typename RadixKey<T>::type first = RadixKey<T>::of(src[0]);
+    std::pmr::vector<typename RadixKey<T>::type> diff(threads, 0, scratch_resource());
+    parallel_for_chunks(pool, threads, [&](int i) {
+        diff[i] = radix_key_diff(src, n * i / threads, n * (i + 1) / threads, first);
+    });
+
+    typename RadixKey<T>::type all = 0;
+    for (auto bits : diff) all |= bits;
+    return radix_top_digit<T>(all);
+}
+
+/**
+ * @brief One parallel MSD pass on digit 'top', then the buckets on the pool.
+ *
+ * Every thread counts its chunk, the per-thread prefix sums give each thread
+ * its own write positions per bucket, and the chunks are scattered from 'src'
+ * into 'other'. Buckets larger than a fair share of the threads take another
+ * parallel pass on the next digit; the others are submitted to 'group' as one
+ * radix_sort_sequential task each. Runs on the calling thread, which
+ * must wait on 'group' even if this throws: submitted tasks use both arrays.
+ * Its working arrays come from scratch_resource().
+ *
+ * @param out Where the sorted elements end up: src or other
+ */
+template<typename T>
+void radix_sort_msd(T* src, T* other, std::ptrdiff_t n, int top, T* out, ThreadPool& pool, int threads, TaskGroup& group) {
+    using Key = RadixKey<T>;
+    std::pmr::vector<RadixHistogram> offsets(threads, RadixHistogram{}, scratch_resource());
+    parallel_for_chunks(pool, threads, [&](int i) {
+        RadixHistogram& count = offsets[i];
+        for (std::ptrdiff_t j = n * i / threads, end = n * (i + 1) / threads; j < end; ++j) {
+            ++count[Key::digit(src[j], top)];
+        }
+    });
+
+    // Bucket-major, thread-minor: thread i writes bucket b after threads 0 .. i - 1
+    RadixHistogram starts;
+    std::ptrdiff_t sum = 0;
+    for (std::size_t b = 0; b < RADIX_BUCKETS; ++b) {
+        starts[b] = sum;
+        for (int i = 0; i < threads; ++i) {
+            std::ptrdiff_t count = offsets[i][b];
+            offsets[i][b] = sum;
+            sum += count;
+        }
+    }
+
+    parallel_for_chunks(pool, threads, [&](int i) {
+        RadixHistogram& offset = offsets[i];
+        for (std::ptrdiff_t j = n * i / threads, end = n * (i + 1) / threads; j < end; ++j) {
+            T x = src[j];
+            other[offset[Key::digit(x, top)]++] = x;
+        }
+    });
+
+    // Large buckets last: their passes run while the workers sort the small ones
+    std::pmr::vector<std::size_t> large(scratch_resource());
+    for (std::size_t b = 0; b < RADIX_BUCKETS; ++b) {
+        std::ptrdiff_t begin = starts[b];
+        std::ptrdiff_t length = (b + 1 < RADIX_BUCKETS ? starts[b + 1] : n) - begin;
+        if (length == 0) continue;
+        if (top > 0 && length >= 2 * MIN_PARALLEL_RADIX_CHUNK && length > n / threads) {
+            large.push_back(b);
+            continue;
+        }
+        T* data = other + begin;
+        T* scratch = src + begin;
+        T* target = out + begin;
+        pool.submit(group, [data, scratch, length, top, target] {
+            radix_sort_sequential(data, scratch, length, top, target);
+        });
+    }
+
+    for (std::size_t b : large) {
+        std::ptrdiff_t begin = starts[b];
+        std::ptrdiff_t length = (b + 1 < RADIX_BUCKETS ? starts[b + 1] : n) - begin;
+        int bucket_threads = static_cast<int>(std::min<std::ptrdiff_t>(threads, length / MIN_PARALLEL_RADIX_CHUNK));
+        int next = radix_top_digit(other + begin, length, pool, bucket_threads);
+        if (next < 0) {
+            if (out != other) std::copy(other + begin, other + begin + length, out + begin);
+            continue;
+        }
+        radix_sort_msd(other + begin, src + begin, length, next, out + begin, pool, bucket_threads, group);
+    }
+}
+
+/**
+ * @brief Radix sort of a range of integers or floating-point values in ascending order.
+ *
+ * The elements are sorted by RadixKey, 8 bits per digit, using a scratch buffer
+ * of the range size. Digits in which all keys agree (e.g. the high bytes of
+ * timestamps or of small IDs) cost no pass.
+ *
+ * - Sequential (parallelism <= 1 or small ranges): LSD passes, after one MSD
+ *   pass for ranges larger than MAX_RADIX_LSD_SIZE.
+ * - Parallel: the highest differing digit is distributed by all threads with
+ *   per-thread histograms and prefix sums, then each bucket is finished
+ *   sequentially as a pool task.
+ *
+ * The order of NaNs and of -0.0/+0.0 is the one of sort_floats.
+ *
+ * @param a Pointer to the array.
+ * @param low Starting index (inclusive).
+ * @param high Ending index (exclusive).
+ * @param parallelism Number of threads to use (0 or 1 for sequential).
+ */
+template<typename T>
+void radix_sort(T* a, std::ptrdiff_t low, std::ptrdiff_t high, int parallelism = 1) {
+    static_assert(is_radix_sortable_v<T>, "radix_sort needs 4- or 8-byte integers, float or double");
+    std::ptrdiff_t size = high - low;
+    if (size < 2) return;
+    T* data = a + low;
+
+    std::ptrdiff_t threads = parallelism > 1 ? std::min<std::ptrdiff_t>(parallelism, size / MIN_PARALLEL_RADIX_CHUNK) : 1;
+    if (threads < 2) {
+        ScratchBuffer<T> buffer(static_cast<std::size_t>(size));
+        radix_sort_sequential(data, buffer.data(), size, RadixKey<T>::DIGITS, data);
+        return;
+    }
+
+    auto& pool = getThreadPool(parallelism);
+    int top = radix_top_digit(data, size, pool, static_cast<int>(threads));
+    if (top < 0) return;
+
+    TaskGroup group(parallelism);
+    // First touched within the sort's budget, as in parallelMergeSort
+    ScratchBuffer<T> buffer(static_cast<std::size_t>(size), group);
+    try {
+        radix_sort_msd(data, buffer.data(), size, top, data, pool, static_cast<int>(threads), group);
+    } catch (...) {
+        // The submitted buckets still write into 'buffer' and 'a': rethrown by wait() below
+        group.capture_exception(std::current_exception());
+    }
+    pool.wait(group);
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_RADIX_SORT_HPP
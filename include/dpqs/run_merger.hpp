@@ -2,10 +2,14 @@
 #define DPQS_RUN_MERGER_HPP
 
 #include <vector>
+#include <atomic>
+#include <memory_resource>
 #include <algorithm>
 #include "dpqs/constants.hpp"
 #include "dpqs/merge_ops.hpp"
 #include "dpqs/parallel/merger.hpp"
+#include "dpqs/parallel/buffer_manager.hpp"
+#include "dpqs/stop_condition.hpp"
 
 namespace dual_pivot {
 
@@ -34,57 +38,26 @@ namespace dual_pivot {
  * - Reduced number of comparisons and swaps
  */
 
-// Forward declarations for run merging functions
-template<typename T, typename Compare>
-T* merge_runs(T* a, T* b, std::ptrdiff_t offset, int aim,
-             const std::vector<std::ptrdiff_t>& run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp);
-
+// Forward declarations for run merging functions (merge_runs: parallel/merger.hpp)
 template<typename T, typename Compare>
 void merge_parts(T* dst, std::ptrdiff_t k, T* a1, std::ptrdiff_t lo1, std::ptrdiff_t hi1, T* a2, std::ptrdiff_t lo2, std::ptrdiff_t hi2, Compare comp);
 
 /**
- * @brief Attempts to detect and merge sorted runs for optimized sorting
- *
- * This function implements an advanced run detection algorithm that identifies
- * naturally occurring sorted subsequences in the array. If sufficient runs
- * are found with adequate length, it merges them using an optimized merge
- * strategy, potentially achieving O(n) or near-O(n) performance.
+ * @brief Identifies the runs of a[low, high), the first pass of try_merge_runs.
  *
- * Run Detection Strategy:
- * 1. Scan array to identify ascending, descending, and constant sequences
- * 2. Reverse descending sequences to make them ascending
- * 3. Validate that initial runs are long enough to justify merge overhead
- * 4. Track run boundaries in a compact integer array
- * 5. Merge runs using recursive divide-and-conquer if beneficial
+ * Descending runs are reversed into ascending order. On success 'run' holds
+ * the start of every run followed by 'high', or stays empty if the whole range
+ * is one monotonous sequence (already sorted). Fails, possibly after reversing
+ * some runs, if the first run is shorter than 'min_first_run', the runs are
+ * too short for their number, or there are 'capacity' runs.
  *
- * Quality Heuristics:
- * - Initial runs must be at least MIN_FIRST_RUN_SIZE elements
- * - Total run count limited to MAX_RUN_CAPACITY to avoid overhead
- * - First runs factor validates that runs are long enough relative to total size
- * - Early termination if runs are too short or too numerous
- *
- * Parallel Optimization:
- * - Uses parallel run merging for large run counts (>= MIN_RUN_COUNT)
- * - Falls back to sequential merging for smaller run sets
- * - Maintains cache efficiency through localized processing
- *
- * @tparam T Element type (must support comparison and assignment)
- * @tparam Compare Comparator type
- * @param a Pointer to the array to analyze and potentially sort
- * @param low Starting index of the range to process
- * @param size Number of elements in the range
- * @param comp Comparator instance
- * @param parallel Whether to use parallel merging (default: false)
- * @return true if runs were detected and merged (array is now sorted)
- * @return false if run detection failed (caller should use different algorithm)
+ * @param found Run starts found by all chunks of a parallel scan (nullptr if
+ *        none): the scan also fails once they reach capacity - 1
  */
 template<typename T, typename Compare>
-bool try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp, bool parallel = false) {
-    // Run array stores start indices of sorted subsequences
-    // Only constructed if initial analysis shows promising run structure
-    // run[i] holds the starting index of the i-th run
-    std::vector<std::ptrdiff_t> run;
-    std::ptrdiff_t high = low + size;
+bool scan_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp,
+               std::pmr::vector<std::ptrdiff_t>& run, std::ptrdiff_t min_first_run, std::ptrdiff_t capacity,
+               std::atomic<std::ptrdiff_t>* found = nullptr) {
     std::ptrdiff_t count = 1, last = low;
 
     // Identify all possible runs
@@ -100,7 +73,7 @@ bool try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp,
             while (++k < high && !comp(a[k - 1], a[k]));
 
             // Reverse into ascending order
-            for (int i = last - 1, j = k; ++i < --j && comp(a[j], a[i]); ) {
+            for (std::ptrdiff_t i = last - 1, j = k; ++i < --j && comp(a[j], a[i]); ) {
                 T temp = a[i];
                 a[i] = a[j];
                 a[j] = temp;
@@ -122,13 +95,15 @@ bool try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp,
                 return true;
             }
 
-            if (k - low < MIN_FIRST_RUN_SIZE) {
+            if (k - low < min_first_run) {
                 // The first run is too small
                 // to proceed with scanning.
                 return false;
             }
 
-            run.reserve(((size >> 10) | 0x7F) & 0x3FF);
+            // Reserved once: at most 'capacity' entries, and no reallocation
+            // leaves holes in a ScratchArena
+            run.reserve(static_cast<std::size_t>(capacity));
             run.push_back(low);
             run.push_back(last = k);
 
@@ -139,45 +114,205 @@ bool try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp,
                 return false;
             }
 
-            if (++count == MAX_RUN_CAPACITY) {
+            if (++count == capacity) {
                 // Array is not highly structured.
                 return false;
             }
+            if (found != nullptr && found->fetch_add(1, std::memory_order_relaxed) + 1 >= capacity - 1) {
+                // Too many runs in all chunks together
+                return false;
+            }
             run.push_back(last = k);
         } else {
             run.back() = last = k;
         }
     }
+    return true;
+}
 
-    // Merge runs of highly structured array
-    if (count > 1) {
-        std::vector<T> b(size);
-
-        if (parallel && count >= MIN_RUN_COUNT) {
-            // Use parallel run merging for large run counts
-            auto* merger = new RunMerger<T, Compare>(nullptr, a, b.data(), low, 1, run, 0, count, comp);
-            merger->invoke();
-            merger->wait();
-            T* result = merger->result;
-            delete merger;
-
-            // Copy back to main array if needed
-            if (result != a) {
-                std::copy(result + low, result + low + size, a + low);
+/**
+ * @brief Joins the run lists of consecutive chunks into 'run'.
+ *
+ * Each part holds the start of its chunk followed by the end of every run in
+ * it. Where the first run of a chunk continues in order from the last run of
+ * the previous chunk, the two become one run.
+ *
+ * @return false if there would be 'capacity' runs or more
+ */
+template<typename T, typename Compare>
+bool stitch_runs(const T* a, const std::vector<std::pmr::vector<std::ptrdiff_t>>& parts, Compare comp,
+                 std::pmr::vector<std::ptrdiff_t>& run, std::ptrdiff_t capacity) {
+    run.push_back(parts.front().front());
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        std::size_t first = 1;
+        std::ptrdiff_t start = parts[i][0];
+        if (i > 0 && !comp(a[start], a[start - 1])) {
+            run.back() = parts[i][1];
+            first = 2;
+        }
+        for (std::size_t j = first; j < parts[i].size(); ++j) {
+            if (static_cast<std::ptrdiff_t>(run.size()) == capacity) {
+                // Array is not highly structured.
+                return false;
             }
-        } else {
-            // Use sequential merging
-            merge_runs(a, b.data(), low, 1, run, 0, count, comp);
+            run.push_back(parts[i][j]);
         }
     }
     return true;
 }
 
+/**
+ * @brief scan_runs on several threads, same contract.
+ *
+ * The range is cut into chunks of at least MIN_PARALLEL_RUN_SCAN_CHUNK
+ * elements, one per thread of the concurrency budget, and each chunk is
+ * scanned on its own. Where the last run of a chunk continues in order into
+ * the first run of the next, the two runs are joined; a descending run that
+ * crosses a chunk boundary stays two ascending runs. Input without structure
+ * fails on its first MIN_FIRST_RUN_SIZE elements, before any task is submitted,
+ * and the chunks share one count of run starts, so all of them stop once the
+ * runs are too many for MAX_RUN_CAPACITY or one chunk has failed.
+ */
+template<typename T, typename Compare>
+bool scan_runs_parallel(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, std::pmr::vector<std::ptrdiff_t>& run) {
+    std::ptrdiff_t size = high - low;
+    bool ascending = true, descending = true;
+    for (std::ptrdiff_t k = low + 1; k < low + MIN_FIRST_RUN_SIZE && k < high; ++k) {
+        ascending = ascending && !comp(a[k], a[k - 1]);
+        descending = descending && !comp(a[k - 1], a[k]);
+    }
+    if (!ascending && !descending) {
+        return false;
+    }
+
+    auto& pool = getThreadPool();
+    std::ptrdiff_t threads = std::min(concurrency_budget(pool), size / MIN_PARALLEL_RUN_SCAN_CHUNK);
+    if (threads < 2) {
+        return scan_runs(a, low, high, comp, run, MIN_FIRST_RUN_SIZE, MAX_RUN_CAPACITY);
+    }
+
+    // The chunks are scanned on pool threads, so their run lists come from the
+    // thread-safe scratch pool rather than the caller's resource
+    int chunks = static_cast<int>(threads);
+    std::vector<std::pmr::vector<std::ptrdiff_t>> parts;
+    parts.reserve(static_cast<std::size_t>(chunks));
+    for (int i = 0; i < chunks; ++i) {
+        parts.emplace_back(&BufferManager::instance());
+    }
+    // Stitching removes at most one run start per chunk boundary, so capacity - 1
+    // starts found before stitching are too many
+    std::atomic<std::ptrdiff_t> found{0};
+    std::vector<char> structured(static_cast<std::size_t>(chunks), 0);
+    parallel_for_chunks(pool, chunks, [&](int i) {
+        std::ptrdiff_t from = low + size * i / chunks;
+        std::ptrdiff_t to = low + size * (i + 1) / chunks;
+        // Only the first chunk starts at the start of a run
+        structured[i] = scan_runs(a, from, to, comp, parts[i], i == 0 ? MIN_FIRST_RUN_SIZE : 0, MAX_RUN_CAPACITY, &found);
+        if (!structured[i]) {
+            found.store(MAX_RUN_CAPACITY, std::memory_order_relaxed);
+        } else if (parts[i].empty()) {
+            parts[i].assign({from, to});
+        }
+    });
+    for (char ok : structured) {
+        if (!ok) return false;
+    }
+    run.reserve(MAX_RUN_CAPACITY);
+    return stitch_runs(a, parts, comp, run, MAX_RUN_CAPACITY);
+}
+
+/**
+ * @brief Attempts to detect and merge sorted runs for optimized sorting
+ *
+ * This function implements an advanced run detection algorithm that identifies
+ * naturally occurring sorted subsequences in the array. If sufficient runs
+ * are found with adequate length, it merges them using an optimized merge
+ * strategy, potentially achieving O(n) or near-O(n) performance.
+ *
+ * Run Detection Strategy:
+ * 1. Scan array to identify ascending, descending, and constant sequences
+ * 2. Reverse descending sequences to make them ascending
+ * 3. Validate that initial runs are long enough to justify merge overhead
+ * 4. Track run boundaries in a compact integer array
+ * 5. Merge runs using recursive divide-and-conquer if beneficial
+ *
+ * Quality Heuristics:
+ * - Initial runs must be at least MIN_FIRST_RUN_SIZE elements
+ * - Total run count limited to MAX_RUN_CAPACITY to avoid overhead
+ * - First runs factor validates that runs are long enough relative to total size
+ * - Early termination if runs are too short or too numerous
+ *
+ * Parallel Optimization:
+ * - Scans chunks of large ranges on several threads (scan_runs_parallel)
+ * - Merges independent halves of the merge tree on different threads (a
+ *   RunMerger tree), and splits each large merge across threads (parallel_merge_parts)
+ * - Only forks and joins through the pool, so it may run inside a pool task
+ *
+ * @tparam T Element type (must support comparison and assignment)
+ * @tparam Compare Comparator type
+ * @param a Pointer to the array to analyze and potentially sort
+ * @param low Starting index of the range to process
+ * @param size Number of elements in the range
+ * @param comp Comparator instance
+ * @param parallel Whether to use parallel scanning and merging (default: false)
+ * @return true if runs were detected and merged (array is now sorted)
+ * @return false if run detection failed (caller should use different algorithm)
+ */
+template<typename T, typename Compare>
+bool try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp, bool parallel = false) {
+    // Run array stores start indices of sorted subsequences
+    // Only constructed if initial analysis shows promising run structure
+    // run[i] holds the starting index of the i-th run
+    // Scratch memory, like the merge buffer, comes from scratch_resource()
+    std::pmr::vector<std::ptrdiff_t> run(scratch_resource());
+    std::ptrdiff_t high = low + size;
+
+    bool structured = (parallel && size >= 2 * MIN_PARALLEL_RUN_SCAN_CHUNK)
+        ? scan_runs_parallel(a, low, high, comp, run)
+        : scan_runs(a, low, high, comp, run, MIN_FIRST_RUN_SIZE, MAX_RUN_CAPACITY);
+    if (!structured) {
+        return false;
+    }
+    // Stopped: the runs (descending ones reversed) stay unmerged
+    if (sort_stop_requested()) {
+        return true;
+    }
+
+    // Merge runs of highly structured array
+    std::ptrdiff_t count = run.empty() ? 1 : static_cast<std::ptrdiff_t>(run.size()) - 1;
+    if (count > 1) {
+        ScratchBuffer<T> b(size, parallel);
+        merge_runs(a, b.data(), low, 1, run.data(), 0, count, comp, parallel);
+    }
+    return true;
+}
+
+/**
+ * @brief try_merge_runs on up to 'parallelism' threads, for callers outside the pool.
+ *
+ * Runs as a task group of its own, so the scan and the merges stay within the
+ * budget of the sort.
+ */
+template<typename T, typename Compare>
+bool parallel_try_merge_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t size, Compare comp, int parallelism) {
+    if (parallelism <= 1) {
+        return try_merge_runs(a, low, size, comp);
+    }
+    auto& pool = getThreadPool(parallelism);
+    TaskGroup group(parallelism);
+    bool merged = false;
+    pool.submit(group, [&] { merged = try_merge_runs(a, low, size, comp, true); });
+    pool.wait(group);
+    return merged;
+}
+
 template<typename T, typename Compare>
 T* merge_runs(T* a, T* b, std::ptrdiff_t offset, int aim,
-             const std::vector<std::ptrdiff_t>& run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp) {
+             const std::ptrdiff_t* run, std::ptrdiff_t lo, std::ptrdiff_t hi, Compare comp,
+             bool parallel) {
 
-    if (hi - lo == 1) {
+    // A single run, or runs left unmerged because the sort was stopped
+    if (hi - lo == 1 || sort_stop_requested()) {
         if (aim >= 0) {
             return a;
         }
@@ -187,14 +322,19 @@ T* merge_runs(T* a, T* b, std::ptrdiff_t offset, int aim,
         return b;
     }
 
+    // Large merge trees fork their halves as a RunMerger tree
+    if (parallel && run[hi] - run[lo] >= 2 * MIN_PARALLEL_MERGE_CHUNK) {
+        return RunMerger<T, Compare>::merge(a, b, offset, aim, run, lo, hi, comp);
+    }
+
     // Split into approximately equal parts
     std::ptrdiff_t mi = lo;
     std::ptrdiff_t rmi = (run[lo] + run[hi]) >> 1;
     while (run[++mi + 1] <= rmi);
 
     // Merge the left and right parts
-    T* a1 = merge_runs(a, b, offset, -aim, run, lo, mi, comp);
-    T* a2 = merge_runs(a, b, offset, 0, run, mi, hi, comp);
+    T* a1 = merge_runs(a, b, offset, -aim, run, lo, mi, comp, parallel);
+    T* a2 = merge_runs(a, b, offset, 0, run, mi, hi, comp, parallel);
 
     T* dst = (a1 == a) ? b : a;
 
@@ -204,7 +344,14 @@ T* merge_runs(T* a, T* b, std::ptrdiff_t offset, int aim,
     std::ptrdiff_t lo2 = (a2 == b) ? run[mi] - offset : run[mi];
     std::ptrdiff_t hi2 = (a2 == b) ? run[hi] - offset : run[hi];
 
-    merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    if (sort_stop_requested()) {
+        // Stopped: only move both parts into dst, unmerged
+        merge_tail(dst, k, a1, lo1, hi1, a2, lo2, hi2);
+    } else if (parallel) {
+        parallel_merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    } else {
+        merge_parts(dst, k, a1, lo1, hi1, a2, lo2, hi2, comp);
+    }
     return dst;
 }
 
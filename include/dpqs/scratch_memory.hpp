@@ -0,0 +1,113 @@
+#ifndef DPQS_SCRATCH_MEMORY_HPP
+#define DPQS_SCRATCH_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#include "dpqs/constants.hpp"
+
+namespace dual_pivot {
+
+/**
+ * @brief Resource set by the innermost ScratchResourceScope of the calling thread (nullptr if none).
+ *
+ * Sorts read it through scratch_resource() (parallel/buffer_manager.hpp), which
+ * falls back to the per-thread scratch pool.
+ */
+inline std::pmr::memory_resource*& scratch_resource_slot() {
+    thread_local std::pmr::memory_resource* resource = nullptr;
+    return resource;
+}
+
+/**
+ * @brief Sets the scratch resource of the calling thread for its lifetime.
+ *
+ * Scopes nest; the destructor restores the previous resource.
+ */
+class ScratchResourceScope {
+public:
+    explicit ScratchResourceScope(std::pmr::memory_resource* resource) : previous(scratch_resource_slot()) {
+        scratch_resource_slot() = resource;
+    }
+
+    ~ScratchResourceScope() {
+        scratch_resource_slot() = previous;
+    }
+
+    ScratchResourceScope(const ScratchResourceScope&) = delete;
+    ScratchResourceScope& operator=(const ScratchResourceScope&) = delete;
+
+private:
+    std::pmr::memory_resource* previous;
+};
+
+/**
+ * @brief Stack allocator over caller-provided memory; never touches the heap.
+ *
+ * Allocations are carved from the memory in order, and freeing the most
+ * recent block gives its memory back. The sorts free their scratch in reverse
+ * order of allocation, so one arena serves any number of sorts. A request
+ * that does not fit throws std::bad_alloc. Not thread-safe.
+ */
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    ScratchArena(void* memory, std::size_t bytes) : base(static_cast<std::byte*>(memory)), capacity(bytes) {}
+
+#if __cplusplus >= 202002L
+    explicit ScratchArena(std::span<std::byte> memory) : ScratchArena(memory.data(), memory.size()) {}
+#endif
+
+    /// Bytes in use (allocated and not yet released)
+    std::size_t used() const { return top; }
+
+    /// Largest number of bytes in use at any time
+    std::size_t peak() const { return high_water; }
+
+private:
+    std::byte* base;
+    std::size_t capacity;
+    std::size_t top = 0;
+    std::size_t high_water = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(base) + top;
+        std::size_t start = top + ((alignment - address % alignment) % alignment);
+        if (start > capacity || bytes > capacity - start) {
+            throw std::bad_alloc();
+        }
+        top = start + bytes;
+        if (top > high_water) high_water = top;
+        return base + start;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t) override {
+        // Only the most recent block can be given back
+        if (static_cast<std::byte*>(p) + bytes == base + top) {
+            top = static_cast<std::size_t>(static_cast<std::byte*>(p) - base);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * @brief Bytes of scratch memory a sequential sort of n elements of type T needs at most.
+ *
+ * Enough for the run array and a merge or radix buffer of n elements at the
+ * same time, with room for alignment. Sizes a ScratchArena for sort_with_scratch.
+ */
+template<typename T>
+constexpr std::size_t sort_scratch_size(std::ptrdiff_t n) {
+    return static_cast<std::size_t>(n) * sizeof(T) + alignof(T) +
+           static_cast<std::size_t>(MAX_RUN_CAPACITY) * sizeof(std::ptrdiff_t) + alignof(std::ptrdiff_t);
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_SCRATCH_MEMORY_HPP
@@ -0,0 +1,120 @@
+#ifndef DPQS_SIMD_MERGE_HPP
+#define DPQS_SIMD_MERGE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include "dpqs/cpu_features.hpp"
+
+#if DPQS_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace dual_pivot {
+
+/**
+ * @brief Element types with a vectorized bitonic merge kernel.
+ *
+ * 4-byte integers in std::less order: equal keys cannot be told apart, so the
+ * network gives exactly the output of the scalar merge. Floating-point types are
+ * excluded because the vector min/max do not keep -0.0 and +0.0 apart.
+ */
+template<typename T, typename Compare>
+constexpr bool use_bitonic_merge_v = DPQS_HAS_X86_SIMD &&
+    (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>>) &&
+    std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) == 4;
+
+#if DPQS_HAS_X86_SIMD
+
+template<bool Signed>
+DPQS_TARGET_AVX2 inline __m256i merge_min_epi32(__m256i x, __m256i y) {
+    return Signed ? _mm256_min_epi32(x, y) : _mm256_min_epu32(x, y);
+}
+
+template<bool Signed>
+DPQS_TARGET_AVX2 inline __m256i merge_max_epi32(__m256i x, __m256i y) {
+    return Signed ? _mm256_max_epi32(x, y) : _mm256_max_epu32(x, y);
+}
+
+/**
+ * @brief Sorts a bitonic vector of 8 keys (half-cleaners at distance 4, 2, 1).
+ */
+template<bool Signed>
+DPQS_TARGET_AVX2 inline __m256i bitonic_sort_8(__m256i v) {
+    __m256i p = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(merge_min_epi32<Signed>(v, p), merge_max_epi32<Signed>(v, p), 0xF0);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_epi32(merge_min_epi32<Signed>(v, p), merge_max_epi32<Signed>(v, p), 0xCC);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm256_blend_epi32(merge_min_epi32<Signed>(v, p), merge_max_epi32<Signed>(v, p), 0xAA);
+    return v;
+}
+
+/**
+ * @brief Merges two sorted vectors of 8 keys: 'low' gets the 8 smallest keys,
+ * 'high' the 8 largest, both sorted.
+ */
+template<bool Signed>
+DPQS_TARGET_AVX2 inline void bitonic_merge_8x8(__m256i& low, __m256i& high) {
+    // low followed by reversed high is a bitonic sequence of 16 keys
+    const __m256i reversed = _mm256_permutevar8x32_epi32(high, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i mn = merge_min_epi32<Signed>(low, reversed);
+    __m256i mx = merge_max_epi32<Signed>(low, reversed);
+    low = bitonic_sort_8<Signed>(mn);
+    high = bitonic_sort_8<Signed>(mx);
+}
+
+/**
+ * @brief Vector part of the bitonic merge of a1[lo1, hi1) and a2[lo2, hi2) into dst[k, ...).
+ *
+ * Each step loads the next 8 keys of the segment with the smaller head, merges
+ * them with the 8 keys carried over from the previous step and stores the lower
+ * half. It stops when a segment has fewer than 8 keys left and then gives the
+ * carried keys back to their segments (the largest keys read so far, so taken
+ * back from the segment ends), leaving lo1, lo2 and k where a scalar merge
+ * continues. Both segments must have at least 8 keys.
+ *
+ * Stores never pass the first unread key of a segment that ends where the
+ * output ends, so a destination overlapping a2 (or a1, with the gap
+ * merge_parts needs) stays correct.
+ */
+template<typename T>
+DPQS_TARGET_AVX2 void merge_bitonic_avx2(T* dst, std::ptrdiff_t& k, const T* a1, std::ptrdiff_t& lo1, std::ptrdiff_t hi1,
+                                         const T* a2, std::ptrdiff_t& lo2, std::ptrdiff_t hi2) {
+    static_assert(sizeof(T) == 4 && std::is_integral_v<T>, "bitonic merge kernel handles 4-byte integers");
+    constexpr bool SIGNED = std::is_signed_v<T>;
+    const std::ptrdiff_t start1 = lo1;
+    const std::ptrdiff_t start2 = lo2;
+
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a1 + lo1));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a2 + lo2));
+    lo1 += 8;
+    lo2 += 8;
+    bitonic_merge_8x8<SIGNED>(low, high);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), low);
+    k += 8;
+
+    while (lo1 + 8 <= hi1 && lo2 + 8 <= hi2) {
+        const bool first = a1[lo1] < a2[lo2];
+        low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first ? a1 + lo1 : a2 + lo2));
+        lo1 += first ? 8 : 0;
+        lo2 += first ? 0 : 8;
+        bitonic_merge_8x8<SIGNED>(low, high);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), low);
+        k += 8;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (lo2 == start2 || (lo1 > start1 && a2[lo2 - 1] < a1[lo1 - 1])) {
+            --lo1;
+        } else {
+            --lo2;
+        }
+    }
+}
+
+#endif // DPQS_HAS_X86_SIMD
+
+} // namespace dual_pivot
+
+#endif // DPQS_SIMD_MERGE_HPP
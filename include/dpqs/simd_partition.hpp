@@ -0,0 +1,265 @@
+#ifndef DPQS_SIMD_PARTITION_HPP
+#define DPQS_SIMD_PARTITION_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include "dpqs/utils.hpp"
+#include "dpqs/cpu_features.hpp"
+
+#if DPQS_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace dual_pivot {
+
+/**
+ * @brief Element types with a vectorized dual-pivot classification kernel.
+ *
+ * The kernels implement the std::less order of 4- and 8-byte integers and of
+ * float/double (NaN compares false, exactly like the scalar operator<).
+ */
+template<typename T, typename Compare>
+constexpr bool use_simd_partition_v = DPQS_HAS_X86_SIMD &&
+    (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>>) &&
+    ((std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8)) ||
+     std::is_same_v<T, float> || std::is_same_v<T, double>);
+
+#if DPQS_HAS_X86_SIMD
+
+/**
+ * @brief Predicate evaluated by a block classification pass.
+ *
+ * Matches the two passes of partition_dual_pivot_block: the first pass collects
+ * elements not greater than P2, the second one collects elements less than P1.
+ */
+enum class BlockPredicate { NotGreater, Less };
+
+/**
+ * @brief Lookup table turning a comparison bitmask into packed byte offsets.
+ *
+ * Byte i of entry m holds the position of the i-th set bit of m, so one 8-byte
+ * store writes the offsets of all selected lanes of an 8-lane group at once.
+ */
+struct OffsetLookupTable {
+    std::uint64_t entries[256];
+
+    constexpr OffsetLookupTable() : entries{} {
+        for (int mask = 0; mask < 256; ++mask) {
+            std::uint64_t packed = 0;
+            int count = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (mask & (1 << bit)) {
+                    packed |= static_cast<std::uint64_t>(bit) << (8 * count++);
+                }
+            }
+            entries[mask] = packed;
+        }
+    }
+};
+
+inline constexpr OffsetLookupTable offset_lookup_table{};
+
+// Adds `base` to every byte of a packed offset group (offsets stay below 256).
+constexpr std::uint64_t BYTE_BROADCAST = 0x0101010101010101ULL;
+
+/**
+ * @brief Appends the offsets selected by an 8-lane mask, returns how many were appended.
+ *
+ * Always stores 8 bytes, so the offset buffer needs 8 bytes of slack past the block.
+ */
+DPQS_TARGET_AVX2 inline int append_offsets(std::uint8_t* offsets, unsigned mask, int base) {
+    std::uint64_t packed = offset_lookup_table.entries[mask] + static_cast<std::uint64_t>(base) * BYTE_BROADCAST;
+    std::memcpy(offsets, &packed, sizeof(packed));
+    return __builtin_popcount(mask);
+}
+
+template<BlockPredicate Predicate, typename T>
+DPQS_FORCE_INLINE bool block_predicate(const T& x, const T& pivot) {
+    if constexpr (Predicate == BlockPredicate::NotGreater) {
+        return !(pivot < x);
+    } else {
+        return x < pivot;
+    }
+}
+
+/**
+ * @brief Comparison bitmask of one 256-bit vector against the pivot.
+ */
+template<BlockPredicate Predicate, typename T>
+DPQS_TARGET_AVX2 inline unsigned compare_mask_avx2(const T* p, T pivot) {
+    constexpr unsigned lanes = 32 / sizeof(T);
+    constexpr unsigned all = (1u << lanes) - 1;
+    unsigned greater, less;
+
+    if constexpr (std::is_same_v<T, float>) {
+        __m256 v = _mm256_loadu_ps(p);
+        __m256 pv = _mm256_set1_ps(pivot);
+        greater = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, pv, _CMP_GT_OQ)));
+        less = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, pv, _CMP_LT_OQ)));
+    } else if constexpr (std::is_same_v<T, double>) {
+        __m256d v = _mm256_loadu_pd(p);
+        __m256d pv = _mm256_set1_pd(pivot);
+        greater = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, pv, _CMP_GT_OQ)));
+        less = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, pv, _CMP_LT_OQ)));
+    } else if constexpr (sizeof(T) == 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i pv = _mm256_set1_epi32(static_cast<int>(pivot));
+        if constexpr (std::is_unsigned_v<T>) {
+            // Flip the sign bit so the signed comparison orders unsigned values
+            const __m256i bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+            v = _mm256_xor_si256(v, bias);
+            pv = _mm256_xor_si256(pv, bias);
+        }
+        greater = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pv))));
+        less = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pv, v))));
+    } else {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i pv = _mm256_set1_epi64x(static_cast<long long>(pivot));
+        if constexpr (std::is_unsigned_v<T>) {
+            const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+            v = _mm256_xor_si256(v, bias);
+            pv = _mm256_xor_si256(pv, bias);
+        }
+        greater = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, pv))));
+        less = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(pv, v))));
+    }
+
+    if constexpr (Predicate == BlockPredicate::NotGreater) {
+        return ~greater & all;
+    } else {
+        return less;
+    }
+}
+
+/**
+ * @brief Comparison bitmask of one 512-bit vector against the pivot.
+ */
+template<BlockPredicate Predicate, typename T>
+DPQS_TARGET_AVX512 inline unsigned compare_mask_avx512(const T* p, T pivot) {
+    constexpr unsigned lanes = 64 / sizeof(T);
+    constexpr unsigned all = (lanes == 32) ? 0xFFFFFFFFu : ((1u << lanes) - 1);
+    unsigned greater, less;
+
+    if constexpr (std::is_same_v<T, float>) {
+        __m512 v = _mm512_loadu_ps(p);
+        __m512 pv = _mm512_set1_ps(pivot);
+        greater = _mm512_cmp_ps_mask(v, pv, _CMP_GT_OQ);
+        less = _mm512_cmp_ps_mask(v, pv, _CMP_LT_OQ);
+    } else if constexpr (std::is_same_v<T, double>) {
+        __m512d v = _mm512_loadu_pd(p);
+        __m512d pv = _mm512_set1_pd(pivot);
+        greater = _mm512_cmp_pd_mask(v, pv, _CMP_GT_OQ);
+        less = _mm512_cmp_pd_mask(v, pv, _CMP_LT_OQ);
+    } else if constexpr (sizeof(T) == 4) {
+        __m512i v = _mm512_loadu_si512(p);
+        __m512i pv = _mm512_set1_epi32(static_cast<int>(pivot));
+        if constexpr (std::is_unsigned_v<T>) {
+            greater = _mm512_cmp_epu32_mask(v, pv, _MM_CMPINT_NLE);
+            less = _mm512_cmp_epu32_mask(v, pv, _MM_CMPINT_LT);
+        } else {
+            greater = _mm512_cmp_epi32_mask(v, pv, _MM_CMPINT_NLE);
+            less = _mm512_cmp_epi32_mask(v, pv, _MM_CMPINT_LT);
+        }
+    } else {
+        __m512i v = _mm512_loadu_si512(p);
+        __m512i pv = _mm512_set1_epi64(static_cast<long long>(pivot));
+        if constexpr (std::is_unsigned_v<T>) {
+            greater = _mm512_cmp_epu64_mask(v, pv, _MM_CMPINT_NLE);
+            less = _mm512_cmp_epu64_mask(v, pv, _MM_CMPINT_LT);
+        } else {
+            greater = _mm512_cmp_epi64_mask(v, pv, _MM_CMPINT_NLE);
+            less = _mm512_cmp_epi64_mask(v, pv, _MM_CMPINT_LT);
+        }
+    }
+
+    if constexpr (Predicate == BlockPredicate::NotGreater) {
+        return ~greater & all;
+    } else {
+        return less;
+    }
+}
+
+/**
+ * @brief AVX2 block classification: offsets of the elements satisfying Predicate.
+ *
+ * @param block First element of the block
+ * @param n Number of elements in the block (at most BLOCK_PARTITION_SIZE)
+ * @param pivot Pivot value the elements are compared against
+ * @param offsets Output buffer (needs 8 bytes of slack past n)
+ * @return Number of offsets written
+ */
+template<BlockPredicate Predicate, typename T>
+DPQS_TARGET_AVX2 int classify_block_avx2(const T* block, int n, T pivot, std::uint8_t* offsets) {
+    constexpr int lanes = 32 / sizeof(T);
+    int count = 0;
+    int j = 0;
+    for (; j + lanes <= n; j += lanes) {
+        count += append_offsets(offsets + count, compare_mask_avx2<Predicate>(block + j, pivot), j);
+    }
+    for (; j < n; ++j) {
+        offsets[count] = static_cast<std::uint8_t>(j);
+        count += block_predicate<Predicate>(block[j], pivot);
+    }
+    return count;
+}
+
+/**
+ * @brief AVX-512 block classification, same contract as classify_block_avx2.
+ *
+ * 16-lane masks are expanded one byte (8 lanes) at a time through the lookup table.
+ */
+template<BlockPredicate Predicate, typename T>
+DPQS_TARGET_AVX512 int classify_block_avx512(const T* block, int n, T pivot, std::uint8_t* offsets) {
+    constexpr int lanes = 64 / sizeof(T);
+    int count = 0;
+    int j = 0;
+    for (; j + lanes <= n; j += lanes) {
+        unsigned mask = compare_mask_avx512<Predicate>(block + j, pivot);
+        for (int group = 0; group < lanes; group += 8) {
+            count += append_offsets(offsets + count, (mask >> group) & 0xFF, j + group);
+        }
+    }
+    for (; j < n; ++j) {
+        offsets[count] = static_cast<std::uint8_t>(j);
+        count += block_predicate<Predicate>(block[j], pivot);
+    }
+    return count;
+}
+
+/**
+ * @brief Block classifier for partition_dual_pivot_block using AVX2.
+ */
+struct Avx2BlockClassifier {
+    template<typename T, typename Compare>
+    static int not_greater(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare) {
+        return classify_block_avx2<BlockPredicate::NotGreater>(block, n, pivot, offsets);
+    }
+
+    template<typename T, typename Compare>
+    static int less(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare) {
+        return classify_block_avx2<BlockPredicate::Less>(block, n, pivot, offsets);
+    }
+};
+
+/**
+ * @brief Block classifier for partition_dual_pivot_block using AVX-512.
+ */
+struct Avx512BlockClassifier {
+    template<typename T, typename Compare>
+    static int not_greater(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare) {
+        return classify_block_avx512<BlockPredicate::NotGreater>(block, n, pivot, offsets);
+    }
+
+    template<typename T, typename Compare>
+    static int less(const T* block, int n, const T& pivot, std::uint8_t* offsets, Compare) {
+        return classify_block_avx512<BlockPredicate::Less>(block, n, pivot, offsets);
+    }
+};
+
+#endif // DPQS_HAS_X86_SIMD
+
+} // namespace dual_pivot
+
+#endif // DPQS_SIMD_PARTITION_HPP
@@ -0,0 +1,118 @@
+#ifndef DPQS_STABLE_SORT_HPP
+#define DPQS_STABLE_SORT_HPP
+
+#include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <limits>
+#include "dpqs/constants.hpp"
+#include "dpqs/insertion_sort.hpp"
+#include "dpqs/merge_ops.hpp"
+#include "dpqs/run_merger.hpp"
+#include "dpqs/parallel/buffer_manager.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
+#include "dpqs/parallel/threadpool.hpp"
+
+namespace dual_pivot {
+
+/**
+ * @brief Cuts a[low, high) into sorted runs without reordering equal keys.
+ *
+ * Non-descending runs are taken as they are, strictly descending runs are
+ * reversed (they hold no equal keys), and runs shorter than
+ * MIN_STABLE_RUN_SIZE are extended by insertion sort. A run that continues in
+ * order from the previous one is joined to it. The end of every run is
+ * appended to 'run'.
+ */
+template<typename T, typename Compare>
+void scan_stable_runs(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, std::pmr::vector<std::ptrdiff_t>& run) {
+    for (std::ptrdiff_t k = low; k < high; ) {
+        std::ptrdiff_t start = k;
+
+        if (++k < high) {
+            if (comp(a[k], a[k - 1])) {
+                // Strictly descending sequence
+                while (++k < high && comp(a[k], a[k - 1]));
+                std::reverse(a + start, a + k);
+            } else {
+                // Non-descending sequence
+                while (++k < high && !comp(a[k], a[k - 1]));
+            }
+        }
+
+        // Extend short runs; insertion sort keeps equal keys in order
+        if (k - start < MIN_STABLE_RUN_SIZE && k < high) {
+            k = std::min(high, start + MIN_STABLE_RUN_SIZE);
+            insertion_sort(a, start, k, comp);
+        }
+
+        if (start > low && !comp(a[start], a[start - 1])) {
+            run.back() = k;
+        } else {
+            run.push_back(k);
+        }
+    }
+}
+
+/**
+ * @brief Stable sort of a[low, high): adaptive runs, then a ping-pong merge.
+ *
+ * The runs come from scan_stable_runs, on chunks of at least
+ * MIN_PARALLEL_RUN_SCAN_CHUNK elements per thread when parallel, stitched at
+ * the chunk boundaries. They are merged by merge_runs with StableMergeOrder,
+ * so on equal keys the element of the left run goes first; in parallel the
+ * halves of large merge subtrees run on different threads and each large merge
+ * is split with the merge path. Sorted input costs one pass, a few runs
+ * O(n log runs).
+ *
+ * @param parallel Whether to scan and merge on the threads of the current task group
+ */
+template<typename T, typename Compare>
+void stable_sort_range(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, bool parallel) {
+    std::ptrdiff_t size = high - low;
+    if (size <= MIN_STABLE_RUN_SIZE) {
+        insertion_sort(a, low, high, comp);
+        return;
+    }
+
+    // Run list of about size / MIN_STABLE_RUN_SIZE entries on random input
+    std::pmr::vector<std::ptrdiff_t> run(scratch_resource());
+    std::ptrdiff_t threads = 1;
+    if (parallel) {
+        threads = std::min(concurrency_budget(getThreadPool()), size / MIN_PARALLEL_RUN_SCAN_CHUNK);
+    }
+
+    if (threads < 2) {
+        run.push_back(low);
+        scan_stable_runs(a, low, high, comp, run);
+    } else {
+        // Chunk run lists come from the thread-safe scratch pool, as in scan_runs_parallel
+        int chunks = static_cast<int>(threads);
+        std::vector<std::pmr::vector<std::ptrdiff_t>> parts;
+        parts.reserve(static_cast<std::size_t>(chunks));
+        for (int i = 0; i < chunks; ++i) {
+            parts.emplace_back(&BufferManager::instance());
+        }
+        parallel_for_chunks(getThreadPool(), chunks, [&](int i) {
+            std::ptrdiff_t from = low + size * i / chunks;
+            std::ptrdiff_t to = low + size * (i + 1) / chunks;
+            parts[i].push_back(from);
+            scan_stable_runs(a, from, to, comp, parts[i]);
+        });
+
+        std::size_t entries = 0;
+        for (const auto& part : parts) entries += part.size();
+        run.reserve(entries);
+        stitch_runs(a, parts, comp, run, std::numeric_limits<std::ptrdiff_t>::max());
+    }
+
+    std::ptrdiff_t count = static_cast<std::ptrdiff_t>(run.size()) - 1;
+    if (count > 1) {
+        ScratchBuffer<T> b(static_cast<std::size_t>(size), parallel);
+        merge_runs(a, b.data(), low, 1, run.data(), 0, count, StableMergeOrder<Compare>{comp}, parallel);
+    }
+}
+
+} // namespace dual_pivot
+
+#endif // DPQS_STABLE_SORT_HPP
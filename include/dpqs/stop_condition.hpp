@@ -0,0 +1,94 @@
+#ifndef DPQS_STOP_CONDITION_HPP
+#define DPQS_STOP_CONDITION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+
+namespace dual_pivot {
+
+/**
+ * @brief When a sort should give up: a stop token and a deadline.
+ *
+ * Once requested() has returned true it keeps doing so, for every thread of
+ * the sort, and stopped() tells the caller afterwards that work was abandoned.
+ * Thread-safe.
+ */
+class SortStop {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit SortStop(std::stop_token token, clock::time_point deadline = clock::time_point::max())
+        : token(std::move(token)), deadline(deadline) {}
+
+    SortStop(const SortStop&) = delete;
+    SortStop& operator=(const SortStop&) = delete;
+
+    /// Whether the sort should stop now (the token was triggered or the deadline has passed)
+    bool requested() const {
+        if (hit.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (token.stop_requested() || (deadline != clock::time_point::max() && clock::now() >= deadline)) {
+            hit.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /// Whether requested() has returned true, i.e. the sort may not have finished
+    bool stopped() const { return hit.load(std::memory_order_relaxed); }
+
+private:
+    std::stop_token token;
+    clock::time_point deadline;
+    mutable std::atomic<bool> hit{false};
+};
+
+/**
+ * @brief Stop condition set by the innermost SortStopScope of the calling thread (nullptr if none).
+ *
+ * Task groups take the one of the thread that creates them, and the pool sets
+ * it while it runs their tasks, so every task of a sort sees the stop of its caller.
+ */
+inline const SortStop*& sort_stop_slot() {
+    thread_local const SortStop* stop = nullptr;
+    return stop;
+}
+
+/**
+ * @brief Whether the sort running on this thread should stop.
+ *
+ * Polled at partition boundaries and before merges: what is left unsorted
+ * stays in place, so the range remains a permutation of the input.
+ */
+inline bool sort_stop_requested() {
+    const SortStop* stop = sort_stop_slot();
+    return stop != nullptr && stop->requested();
+}
+
+/**
+ * @brief Sets the stop condition of the calling thread for its lifetime.
+ *
+ * Scopes nest; the destructor restores the previous condition.
+ */
+class SortStopScope {
+public:
+    explicit SortStopScope(const SortStop* stop) : previous(sort_stop_slot()) {
+        sort_stop_slot() = stop;
+    }
+
+    ~SortStopScope() {
+        sort_stop_slot() = previous;
+    }
+
+    SortStopScope(const SortStopScope&) = delete;
+    SortStopScope& operator=(const SortStopScope&) = delete;
+
+private:
+    const SortStop* previous;
+};
+
+} // namespace dual_pivot
+
+#endif // DPQS_STOP_CONDITION_HPP
@@ -10,6 +10,7 @@
 #include <string>
 #include <iterator>
 #include <type_traits>
+#include <functional>
 
 // Compiler optimization hints
 #if defined(__GNUC__) || defined(__clang__)
@@ -64,6 +65,37 @@ struct is_contiguous_iterator<Iter, std::enable_if_t<std::contiguous_iterator<It
 template<typename Iter>
 constexpr bool is_contiguous_iterator_v = is_contiguous_iterator<Iter>::value;
 
+/**
+ * @brief Trait marking comparators that are cheap enough to evaluate unconditionally.
+ *
+ * Branchless kernels evaluate the comparator for every element and turn the result
+ * into arithmetic instead of a jump, which only pays off when a comparison is a
+ * single instruction. The standard ordering functors on arithmetic types qualify;
+ * users can specialize this trait for their own trivial functors.
+ */
+template<typename Compare, typename T>
+struct is_cheap_comparator : std::false_type {};
+
+template<typename T>
+struct is_cheap_comparator<std::less<T>, T> : std::is_arithmetic<T> {};
+
+template<typename T>
+struct is_cheap_comparator<std::greater<T>, T> : std::is_arithmetic<T> {};
+
+template<typename T>
+struct is_cheap_comparator<std::less<>, T> : std::is_arithmetic<T> {};
+
+template<typename T>
+struct is_cheap_comparator<std::greater<>, T> : std::is_arithmetic<T> {};
+
+template<typename Compare, typename T>
+constexpr bool is_cheap_comparator_v = is_cheap_comparator<Compare, T>::value;
+
+// Branchless block partitioning moves elements with plain copies, so it is only
+// selected for trivially copyable types with a cheap comparator.
+template<typename T, typename Compare>
+constexpr bool use_block_partition_v = std::is_trivially_copyable_v<T> && is_cheap_comparator_v<Compare, T>;
+
 // Utility functions
 template<typename T>
 DPQS_FORCE_INLINE void swap(T& a, T& b) {
@@ -1,15 +1,24 @@
 #ifndef DUAL_PIVOT_QUICKSORT_HPP
 #define DUAL_PIVOT_QUICKSORT_HPP
 
+#include <chrono>
 #include <concepts>
-#include <concepts>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <stop_token>
 #include "dpqs/utils.hpp"
 #include "dpqs/types.hpp"
 #include "dpqs/parallel/parallel_sort.hpp"
+#include "dpqs/parallel/samplesort.hpp"
 #include "dpqs/sequential_sorters.hpp"
 #include "dpqs/counting_sort.hpp"
+#include "dpqs/radix_sort.hpp"
 #include "dpqs/float_sort.hpp"
 #include "dpqs/iterator_sort.hpp"
+#include "dpqs/stable_sort.hpp"
+#include "dpqs/scratch_memory.hpp"
+#include "dpqs/stop_condition.hpp"
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -28,9 +37,15 @@ namespace dual_pivot {
  *
  * This generic function handles all supported data types and execution modes (sequential/parallel).
  * It automatically dispatches to the most appropriate sorting strategy:
+ * - Parallel samplesort for very large arrays (SAMPLESORT_THRESHOLD elements and more).
  * - Parallel Dual-Pivot Quicksort for large arrays.
  * - Sequential Dual-Pivot Quicksort for smaller arrays or when parallelism is disabled.
  *
+ * An exception thrown by the comparator (or by copying an element), on
+ * whichever thread of the pool it happens, stops the remaining tasks of this
+ * call and is rethrown here once they have finished. The elements of the range
+ * are then valid but in an unspecified order; the pool stays usable.
+ *
  * @tparam T The element type.
  * @tparam Compare The comparator type.
  * @param a Pointer to the array.
@@ -56,6 +71,13 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compar
     // Case 2: Parallel Sort (for types > 2 bytes)
     if (parallelism > 1 && size > MIN_PARALLEL_SORT_SIZE) {
         int depth = getDepth(parallelism, size >> 12);
+        // Very large inputs are bandwidth bound: samplesort needs far fewer passes
+        if constexpr (std::is_default_constructible_v<T>) {
+            if (size >= SAMPLESORT_THRESHOLD) {
+                parallelSampleSort(a, depth, low, high, comp, parallelism);
+                return;
+            }
+        }
         // Use V3 Parallel QuickSort directly (Work Stealing)
         parallelQuickSort(a, depth, low, high, comp, parallelism);
         return;
@@ -65,15 +87,54 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compar
     sort_sequential<T, Compare>(nullptr, a, 0, low, high, comp);
 }
 
+/**
+ * @brief Dual-Pivot Quicksort with an explicit pivot sampling policy.
+ *
+ * Same dispatch as the comparator overload of sort(), but every partitioning step
+ * selects its pivots through PivotSampler (see dpqs/pivot_sampling.hpp), e.g.
+ * ExtremePivotSampler, TertilePivotSampler or AdaptivePivotSampler. Meant for
+ * benchmarking the policies against DefaultPivotSampler.
+ *
+ * @tparam PivotSampler The pivot selection policy.
+ * @tparam T The element type.
+ * @tparam Compare The comparator type.
+ * @param a Pointer to the array.
+ * @param parallelism Number of threads to use (0 or 1 for sequential).
+ * @param low Starting index (inclusive).
+ * @param high Ending index (exclusive).
+ * @param comp The comparator to use.
+ */
+template<typename PivotSampler, typename T, typename Compare = std::less<T>>
+void sort_with_sampler(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp = Compare()) {
+    if (low >= high) return;
+    checkNotNull(a, "array");
+    if (low < 0 || high < 0) {
+        throw std::out_of_range("Invalid range");
+    }
+
+    if (checkEarlyTermination(a, low, high, comp)) {
+        return;
+    }
+
+    if (parallelism > 1 && high - low > MIN_PARALLEL_SORT_SIZE) {
+        int depth = getDepth(parallelism, (high - low) >> 12);
+        parallelQuickSort<T, Compare, PivotSampler>(a, depth, low, high, comp, parallelism);
+        return;
+    }
+
+    sort_sequential<T, Compare, PivotSampler>(nullptr, a, 0, low, high, comp);
+}
+
 /**
  * @brief Main entry point for Dual-Pivot Quicksort.
  *
  * This generic function handles all supported data types and execution modes (sequential/parallel).
  * It automatically dispatches to the most appropriate sorting strategy:
- * - Counting Sort for small integral types (char, short).
+ * - Counting Sort for small integral types (char, short), on several threads for large arrays.
+ * - Radix Sort for 4- and 8-byte integers, float and double (RADIX_SORT_THRESHOLD elements and more).
  * - Parallel Dual-Pivot Quicksort for large arrays of other types.
  * - Sequential Dual-Pivot Quicksort for smaller arrays or when parallelism is disabled.
- * - Specialized handling for floating-point types (NaNs, -0.0).
+ * - Specialized handling for floating-point types (NaNs, -0.0), also on several threads.
  *
  * @tparam T The element type.
  * @param a Pointer to the array.
@@ -89,7 +150,12 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high) {
         throw std::out_of_range("Invalid range");
     }
 
-    if (checkEarlyTermination(a, low, high)) {
+    // NaNs and signed zeros make std::less miss unsorted float ranges
+    if constexpr (std::is_floating_point_v<T>) {
+        if (checkEarlyTermination(a, low, high, float_total_less<T>)) {
+            return;
+        }
+    } else if (checkEarlyTermination(a, low, high)) {
         return;
     }
 
@@ -101,7 +167,7 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high) {
         std::ptrdiff_t threshold = (sizeof(T) == 1) ? MIN_BYTE_COUNTING_SORT_SIZE : MIN_SHORT_OR_CHAR_COUNTING_SORT_SIZE;
 
         if (size >= threshold) {
-            counting_sort(a, low, high);
+            parallel_counting_sort(a, low, high, parallelism);
         } else {
             // Fallback to sequential sort (which handles insertion sort for small arrays)
             sort_sequential<T, std::less<T>>(nullptr, a, 0, low, high, std::less<T>());
@@ -109,13 +175,31 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high) {
         return;
     }
 
-    // Case 2: Parallel Sort (for types > 2 bytes)
+    // Case 2: Integer and floating-point keys -> Radix Sort (sequential or parallel)
+    if constexpr (is_radix_sortable_v<T>) {
+        if (size >= RADIX_SORT_THRESHOLD) {
+            // Mostly sorted integer keys (a few ascending or descending runs) merge faster
+            if constexpr (std::is_integral_v<T>) {
+                if (parallel_try_merge_runs(a, low, size, std::less<T>(), parallelism)) {
+                    return;
+                }
+            }
+            radix_sort(a, low, high, parallelism);
+            return;
+        }
+    }
+
+    // Case 3: Parallel Sort (other types > 2 bytes)
     if (parallelism > 1 && size > MIN_PARALLEL_SORT_SIZE) {
-        sort(a, parallelism, low, high, std::less<T>());
+        if constexpr (std::is_floating_point_v<T>) {
+            parallel_sort_floats(a, low, high, parallelism);
+        } else {
+            sort(a, parallelism, low, high, std::less<T>());
+        }
         return;
     }
 
-    // Case 3: Sequential Sort (fallback)
+    // Case 4: Sequential Sort (fallback)
     if constexpr (std::is_floating_point_v<T>) {
         sort_floats(a, low, high);
     } else {
@@ -123,6 +207,190 @@ void sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high) {
     }
 }
 
+// -----------------------------------------------------------------------------
+// Public API: Caller-provided scratch memory
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief sort() with its scratch memory taken from a caller-provided memory resource.
+ *
+ * The run merger's buffers and the radix buffer come from 'resource' (see
+ * ScratchResourceScope). So do the samplesort buffers of large parallel sorts.
+ * Parallel sorts take their top-level buffers from it on the calling thread.
+ * Tasks running on pool workers use the default resource, and the task
+ * scheduler allocates its own tasks, so only sequential sorts are fully served
+ * by 'resource'.
+ *
+ * @param resource Memory resource for the scratch memory (used on the calling thread only).
+ */
+template<typename T>
+void sort_with_resource(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, std::pmr::memory_resource* resource) {
+    ScratchResourceScope scope(resource);
+    sort(a, parallelism, low, high);
+}
+
+template<typename T, typename Compare>
+void sort_with_resource(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, std::pmr::memory_resource* resource) {
+    ScratchResourceScope scope(resource);
+    sort(a, parallelism, low, high, comp);
+}
+
+template<typename Container>
+void sort_with_resource(Container& container, int parallelism, std::pmr::memory_resource* resource) {
+    sort_with_resource(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()), resource);
+}
+
+/**
+ * @brief Sequential sort() that does not allocate from the heap.
+ *
+ * Every byte of scratch memory comes from 'scratch' through a ScratchArena.
+ * sort_scratch_size<T>(high - low) bytes always suffice; if the arena runs out,
+ * std::bad_alloc is thrown and the range is left partially sorted. One
+ * exception: the counting sort of 1- and 2-byte types keeps per-thread
+ * counting tables, which the first counting sort on a thread allocates once.
+ *
+ * @param scratch Caller-provided memory, e.g. a per-thread arena or a stack buffer.
+ */
+template<typename T>
+void sort_with_scratch(T* a, std::ptrdiff_t low, std::ptrdiff_t high, std::span<std::byte> scratch) {
+    ScratchArena arena(scratch);
+    sort_with_resource(a, 1, low, high, &arena);
+}
+
+template<typename T, typename Compare>
+void sort_with_scratch(T* a, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, std::span<std::byte> scratch) {
+    ScratchArena arena(scratch);
+    sort_with_resource(a, 1, low, high, comp, &arena);
+}
+
+template<typename Container>
+void sort_with_scratch(Container& container, std::span<std::byte> scratch) {
+    sort_with_scratch(container.data(), 0, static_cast<std::ptrdiff_t>(container.size()), scratch);
+}
+
+// -----------------------------------------------------------------------------
+// Public API: Stop tokens and deadlines
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief sort() that gives up once 'stop' is triggered or 'deadline' has passed.
+ *
+ * Every thread of the sort polls the condition (see SortStop) at partition
+ * boundaries and before each merge, and abandons its part: unsorted parts stay
+ * where they are and merges not yet started only move their runs, so the range
+ * is always a permutation of the input. A partition or merge pass under way
+ * finishes first. Pass std::stop_token() for a deadline alone.
+ *
+ * @param stop Stop token of the caller, e.g. of the request the sort serves.
+ * @param deadline Point in time after which the sort stops (none by default).
+ * @return true if the range is sorted, false if the sort stopped first.
+ */
+template<typename T, typename Compare>
+bool sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp, std::stop_token stop,
+          std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+    SortStop condition(std::move(stop), deadline);
+    SortStopScope scope(&condition);
+    sort(a, parallelism, low, high, comp);
+    return !condition.stopped();
+}
+
+/**
+ * @brief Stoppable sort() in natural order.
+ *
+ * Takes the comparison sorts, whose partition and merge steps can stop: the
+ * counting and radix sorts of sort() run their passes to the end. Floating
+ * point values are ordered as by sort() (-0.0 before 0.0, NaNs last).
+ */
+template<typename T>
+bool sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, std::stop_token stop,
+          std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return sort(a, parallelism, low, high, [](T x, T y) { return float_total_less(x, y); }, std::move(stop), deadline);
+    } else {
+        return sort(a, parallelism, low, high, std::less<T>(), std::move(stop), deadline);
+    }
+}
+
+template<typename Container>
+bool sort(Container& container, int parallelism, std::stop_token stop,
+          std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+    return sort(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()), std::move(stop), deadline);
+}
+
+template<typename Container, typename Compare>
+bool sort(Container& container, int parallelism, Compare comp, std::stop_token stop,
+          std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+    return sort(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()), comp, std::move(stop), deadline);
+}
+
+// -----------------------------------------------------------------------------
+// Public API: Stable sort
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Stable sort: elements with equal keys keep their relative order.
+ *
+ * Natural runs are detected (short ones extended by insertion sort) and merged
+ * in pairs between the array and a scratch buffer of high - low elements, see
+ * stable_sort_range. With a parallelism above 1, large ranges are scanned and
+ * merged on up to 'parallelism' threads of the pool. Equal integers cannot be
+ * told apart in std::less order, so those sorts take sort() instead.
+ *
+ * @tparam T The element type (default constructible, for the scratch buffer).
+ * @tparam Compare The comparator type.
+ * @param a Pointer to the array.
+ * @param parallelism Number of threads to use (0 or 1 for sequential).
+ * @param low Starting index (inclusive).
+ * @param high Ending index (exclusive).
+ * @param comp The comparator to use.
+ */
+template<typename T, typename Compare>
+void stable_sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high, Compare comp) {
+    if (low >= high) return;
+    checkNotNull(a, "array");
+    if (low < 0 || high < 0) {
+        throw std::out_of_range("Invalid range");
+    }
+
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                  (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>>)) {
+        sort(a, parallelism, low, high);
+    } else if (parallelism > 1 && high - low > MIN_PARALLEL_SORT_SIZE) {
+        auto& pool = getThreadPool(parallelism);
+        // The scan and the merges stay within the budget of this call's task group
+        TaskGroup group(parallelism);
+        pool.submit(group, [=] { stable_sort_range(a, low, high, comp, true); });
+        pool.wait(group);
+    } else {
+        stable_sort_range(a, low, high, comp, false);
+    }
+}
+
+template<typename T>
+void stable_sort(T* a, int parallelism, std::ptrdiff_t low, std::ptrdiff_t high) {
+    stable_sort(a, parallelism, low, high, std::less<T>());
+}
+
+template<typename Container>
+void stable_sort(Container& container) {
+    stable_sort(container.data(), std::thread::hardware_concurrency(), 0, static_cast<std::ptrdiff_t>(container.size()));
+}
+
+template<typename Container, typename Compare>
+void stable_sort(Container& container, Compare comp) {
+    stable_sort(container.data(), std::thread::hardware_concurrency(), 0, static_cast<std::ptrdiff_t>(container.size()), comp);
+}
+
+template<typename Container>
+void stable_sort(Container& container, int parallelism) {
+    stable_sort(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()));
+}
+
+template<typename Container, typename Compare>
+void stable_sort(Container& container, int parallelism, Compare comp) {
+    stable_sort(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()), comp);
+}
+
 // -----------------------------------------------------------------------------
 // Public API: Convenience wrappers
 // -----------------------------------------------------------------------------
@@ -169,6 +437,11 @@ void sort(Container& container, int parallelism, Compare comp) {
     sort(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()), comp);
 }
 
+template<typename PivotSampler, typename Container>
+void sort_with_sampler(Container& container, int parallelism) {
+    sort_with_sampler<PivotSampler>(container.data(), parallelism, 0, static_cast<std::ptrdiff_t>(container.size()));
+}
+
 template<std::random_access_iterator RandomAccessIterator>
 void dual_pivot_quicksort(RandomAccessIterator first, RandomAccessIterator last) {
     if (first >= last) return;
@@ -195,12 +468,7 @@ void dual_pivot_quicksort(RandomAccessIterator first, RandomAccessIterator last,
         // Use 0 parallelism for default sequential behavior of this specific function name
         sort(a, 0, 0, size, comp);
     } else {
-        // Fallback to vector copy for non-contiguous iterators with custom comparator
-        // until sort_iterator supports custom comparators
-        using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
-        std::vector<ValueType> temp(first, last);
-        sort(temp.data(), 0, 0, size, comp);
-        std::copy(temp.begin(), temp.end(), first);
+        sort_iterator(first, last, comp);
     }
 }
 
@@ -217,10 +485,11 @@ void dual_pivot_quicksort_parallel(RandomAccessIterator first, RandomAccessItera
         auto* a = &(*first);
         sort(a, parallelism, 0, size);
     } else {
+        // The parallel engines need contiguous memory: sort a copy from the scratch resource
         using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
-        std::vector<ValueType> temp(first, last);
+        std::pmr::vector<ValueType> temp(std::make_move_iterator(first), std::make_move_iterator(last), scratch_resource());
         sort(temp.data(), parallelism, 0, size);
-        std::copy(temp.begin(), temp.end(), first);
+        std::move(temp.begin(), temp.end(), first);
     }
 }
 
@@ -237,10 +506,11 @@ void dual_pivot_quicksort_parallel(RandomAccessIterator first, RandomAccessItera
         auto* a = &(*first);
         sort(a, parallelism, 0, size, comp);
     } else {
+        // The parallel engines need contiguous memory: sort a copy from the scratch resource
         using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
-        std::vector<ValueType> temp(first, last);
+        std::pmr::vector<ValueType> temp(std::make_move_iterator(first), std::make_move_iterator(last), scratch_resource());
         sort(temp.data(), parallelism, 0, size, comp);
-        std::copy(temp.begin(), temp.end(), first);
+        std::move(temp.begin(), temp.end(), first);
     }
 }
 
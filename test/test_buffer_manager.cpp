@@ -0,0 +1,170 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+bool aligned(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+void test_size_classes() {
+    std::cout << "Testing BufferManager size classes..." << std::endl;
+
+    assert(BufferManager::block_size(0) == MIN_SCRATCH_BLOCK_BYTES);
+    assert(BufferManager::block_size(1) == MIN_SCRATCH_BLOCK_BYTES);
+    assert(BufferManager::block_size(MIN_SCRATCH_BLOCK_BYTES) == MIN_SCRATCH_BLOCK_BYTES);
+    assert(BufferManager::block_size(MIN_SCRATCH_BLOCK_BYTES + 1) == MIN_SCRATCH_BLOCK_BYTES * 5 / 4);
+    assert(BufferManager::block_size(std::size_t(1) << 20) == std::size_t(1) << 20);
+    assert(BufferManager::block_size((std::size_t(1) << 20) + 1) == (std::size_t(1) << 20) * 5 / 4);
+
+    // Four classes per power of two: at most a quarter wasted, never too small
+    std::size_t previous = 0;
+    for (std::size_t bytes = 1; bytes < (std::size_t(1) << 24); bytes = bytes * 9 / 8 + 1) {
+        std::size_t size = BufferManager::block_size(bytes);
+        assert(size >= bytes);
+        assert(size >= previous);
+        assert(bytes <= MIN_SCRATCH_BLOCK_BYTES || size - bytes < bytes / 4);
+        assert(BufferManager::block_size(size) == size);
+        previous = size;
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_alignment_and_reuse() {
+    std::cout << "Testing BufferManager alignment and reuse..." << std::endl;
+
+    BufferManager& pool = BufferManager::instance();
+    BufferManager::trim();
+    assert(BufferManager::cached_bytes() == 0);
+
+    for (std::size_t bytes : {std::size_t(1), std::size_t(100), std::size_t(5000), std::size_t(300000)}) {
+        void* p = pool.allocate(bytes, alignof(int));
+        assert(aligned(p, SCRATCH_ALIGNMENT));
+        std::memset(p, 0xAB, bytes);
+        pool.deallocate(p, bytes, alignof(int));
+    }
+    void* big = pool.allocate(HUGE_PAGE_SIZE + 1, alignof(double));
+    assert(aligned(big, HUGE_PAGE_SIZE));
+    pool.deallocate(big, HUGE_PAGE_SIZE + 1, alignof(double));
+
+    // Requests of the same class get the freed block back, most recent first
+    std::size_t fresh = BufferManager::fresh_blocks();
+    void* a = pool.allocate(100000, 8);
+    void* b = pool.allocate(110000, 8);
+    assert(BufferManager::fresh_blocks() == fresh + 2);
+    pool.deallocate(b, 110000, 8);
+    void* c = pool.allocate(105000, 8);
+    assert(c == b);
+    assert(BufferManager::fresh_blocks() == fresh + 2);
+    pool.deallocate(c, 105000, 8);
+    pool.deallocate(a, 100000, 8);
+    assert(BufferManager::cached_bytes() > 0);
+
+    BufferManager::trim();
+    assert(BufferManager::cached_bytes() == 0);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_cache_limits() {
+    std::cout << "Testing BufferManager cache limits..." << std::endl;
+
+    BufferManager& pool = BufferManager::instance();
+    BufferManager::trim();
+
+    // At most MAX_CACHED_SCRATCH_BLOCKS blocks stay cached
+    std::vector<void*> blocks;
+    for (std::size_t i = 0; i < MAX_CACHED_SCRATCH_BLOCKS + 8; ++i) {
+        blocks.push_back(pool.allocate(64, 8));
+    }
+    for (void* p : blocks) pool.deallocate(p, 64, 8);
+    assert(BufferManager::cached_bytes() == MAX_CACHED_SCRATCH_BLOCKS * MIN_SCRATCH_BLOCK_BYTES);
+
+    // A block larger than the whole cache is freed at once
+    std::size_t huge = MAX_CACHED_SCRATCH_BYTES + 1;
+    void* p = pool.allocate(huge, 8);
+    pool.deallocate(p, huge, 8);
+    assert(BufferManager::cached_bytes() == MAX_CACHED_SCRATCH_BLOCKS * MIN_SCRATCH_BLOCK_BYTES);
+
+    // A block freed on another thread goes to that thread's cache
+    void* moved = pool.allocate(1 << 20, 8);
+    std::size_t other_cached = 0;
+    std::thread other([&] {
+        pool.deallocate(moved, 1 << 20, 8);
+        other_cached = BufferManager::cached_bytes();
+    });
+    other.join();
+    assert(other_cached == BufferManager::block_size(1 << 20));
+
+    BufferManager::trim();
+    std::cout << "Passed." << std::endl;
+}
+
+void test_huge_pages() {
+    std::cout << "Testing BufferManager huge pages..." << std::endl;
+
+    BufferManager& pool = BufferManager::instance();
+    BufferManager::set_huge_pages(true);
+    assert(BufferManager::huge_pages());
+    std::size_t bytes = 2 * HUGE_PAGE_SIZE;
+    unsigned char* p = static_cast<unsigned char*>(pool.allocate(bytes, 8));
+    assert(aligned(p, HUGE_PAGE_SIZE));
+    std::memset(p, 1, bytes);
+    pool.deallocate(p, bytes, 8);
+    BufferManager::set_huge_pages(false);
+    BufferManager::trim();
+    std::cout << "Passed." << std::endl;
+}
+
+void test_reuse_across_sorts() {
+    std::cout << "Testing buffer reuse across sorts..." << std::endl;
+
+    std::mt19937_64 rng(20);
+    std::vector<int> runs(1 << 20);
+    std::vector<long> longs(1 << 20);
+    for (auto& x : runs) x = static_cast<int>(rng());
+    for (auto& x : longs) x = static_cast<long>(rng());
+    for (int r = 0; r < 4; ++r) {
+        std::sort(runs.begin() + runs.size() * r / 4, runs.begin() + runs.size() * (r + 1) / 4);
+    }
+    std::vector<int> expected_runs = runs;
+    std::vector<long> expected_longs = longs;
+    std::sort(expected_runs.begin(), expected_runs.end());
+    std::sort(expected_longs.begin(), expected_longs.end());
+
+    // The first round fills the cache; later rounds allocate nothing new
+    std::size_t fresh = 0;
+    for (int round = 0; round < 3; ++round) {
+        if (round == 1) fresh = BufferManager::fresh_blocks();
+        std::vector<int> merged = runs;
+        std::vector<long> radix = longs;
+        std::vector<long> parallel = longs;
+        sort(merged, 1);   // run merger
+        sort(radix, 1);    // radix sort
+        sort(parallel, 4); // parallel radix sort
+        assert(merged == expected_runs);
+        assert(radix == expected_longs);
+        assert(parallel == expected_longs);
+    }
+    assert(BufferManager::fresh_blocks() == fresh);
+    assert(BufferManager::cached_bytes() > 0);
+    BufferManager::trim();
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_size_classes();
+    test_alignment_and_reuse();
+    test_cache_limits();
+    test_huge_pages();
+    test_reuse_across_sorts();
+
+    std::cout << "All buffer manager tests passed!" << std::endl;
+    return 0;
+}
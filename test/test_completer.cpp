@@ -0,0 +1,188 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+// Sums [low, high) by halving: leaves add their range, completion adds the halves
+struct SumNode : CountedCompleter<void> {
+    TaskTree<std::less<int>>* tree;
+    const long* values;
+    std::ptrdiff_t low, high;
+    long sum = 0;
+    SumNode* left = nullptr;
+    SumNode* right = nullptr;
+
+    SumNode(SumNode* parent, TaskTree<std::less<int>>* tree, const long* values, std::ptrdiff_t low, std::ptrdiff_t high)
+        : CountedCompleter<void>(parent), tree(tree), values(values), low(low), high(high) {}
+
+    void compute() override {
+        if (high - low <= 64) {
+            for (std::ptrdiff_t i = low; i < high; ++i) sum += values[i];
+        } else {
+            std::ptrdiff_t mid = (low + high) / 2;
+            setPendingCount(2);
+            left = tree->nodes.create<SumNode>(this, tree, values, low, mid);
+            right = tree->nodes.create<SumNode>(this, tree, values, mid, high);
+            left->fork();
+            right->compute();
+        }
+        tryComplete();
+    }
+
+    void onCompletion(CountedCompleter<void>*) override {
+        if (left != nullptr) sum = left->sum + right->sum;
+    }
+};
+
+void test_node_arena() {
+    std::cout << "Testing NodeArena..." << std::endl;
+
+    struct Node { long x[5]; };
+    NodeArena arena(1024);
+    assert(arena.chunk_count() == 0);
+
+    // Nodes are aligned, distinct and keep their values; full chunks are replaced
+    std::vector<Node*> nodes;
+    for (long i = 0; i < 1000; ++i) {
+        Node* node = arena.create<Node>(Node{{i, i, i, i, i}});
+        assert(reinterpret_cast<std::uintptr_t>(node) % alignof(std::max_align_t) == 0);
+        nodes.push_back(node);
+    }
+    for (long i = 0; i < 1000; ++i) assert(nodes[i]->x[0] == i && nodes[i]->x[4] == i);
+    std::size_t chunks = arena.chunk_count();
+    assert(chunks > 1 && chunks < 10);
+
+    // Several threads at once
+    NodeArena shared;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<Node*>> made(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (long i = 0; i < 20000; ++i) made[t].push_back(shared.create<Node>(Node{{t, i, 0, 0, 0}}));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::vector<Node*> all;
+    for (int t = 0; t < 4; ++t) {
+        for (long i = 0; i < 20000; ++i) assert(made[t][i]->x[0] == t && made[t][i]->x[1] == i);
+        all.insert(all.end(), made[t].begin(), made[t].end());
+    }
+    std::sort(all.begin(), all.end());
+    assert(std::adjacent_find(all.begin(), all.end()) == all.end());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_completion() {
+    std::cout << "Testing lock-free completion of a task tree..." << std::endl;
+
+    std::vector<long> values(1 << 20);
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = static_cast<long>(i % 1000);
+    long expected = 0;
+    for (long v : values) expected += v;
+
+    auto& pool = getThreadPool(4);
+    for (int round = 0; round < 20; ++round) {
+        TaskTree<std::less<int>> tree{std::less<int>()};
+        auto* root = tree.nodes.create<SumNode>(nullptr, &tree, values.data(), 0, static_cast<std::ptrdiff_t>(values.size()));
+        TaskGroup group;
+        root->invoke(pool, group);
+        assert(group.done());
+        assert(root->sum == expected);
+        assert(root->getPendingCount() == 0);
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T, typename Compare>
+void check_merge_sort(std::vector<T> data, int depth, int parallelism, Compare comp) {
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), comp);
+    parallelMergeSort(data.data(), depth, 0, static_cast<std::ptrdiff_t>(data.size()), comp, parallelism);
+    assert(data == expected);
+}
+
+void test_sorter_tree() {
+    std::cout << "Testing the Sorter tree (merge and quicksort modes)..." << std::endl;
+
+    assert(getMergeDepth(4, 1000) == 0);
+    assert(getMergeDepth(8, 1000) == -2);
+    assert(getMergeDepth(64, 1000) == -4);
+    assert(getMergeDepth(64, 2) == 0);
+
+    std::mt19937 rng(23);
+    for (std::size_t n : {std::size_t(5000), std::size_t(100000), std::size_t(1000000)}) {
+        std::vector<int> random(n), few(n), organ(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            random[i] = static_cast<int>(rng());
+            few[i] = static_cast<int>(rng() % 7);
+            organ[i] = static_cast<int>(i < n / 2 ? i : n - i);
+        }
+        for (int depth : {0, -2, -4}) {
+            for (int parallelism : {2, 4, 8}) {
+                check_merge_sort(random, depth, parallelism, std::less<int>());
+                check_merge_sort(few, depth, parallelism, std::greater<int>());
+                check_merge_sort(organ, depth, parallelism, std::less<int>());
+            }
+        }
+    }
+
+    // A comparator that is not trivially destructible stays in the TaskTree
+    std::vector<std::string> strings(200000);
+    for (auto& s : strings) s = std::to_string(rng() % 100000);
+    std::function<bool(const std::string&, const std::string&)> by_value = std::less<std::string>();
+    check_merge_sort(strings, -2, 4, by_value);
+
+    // A subrange
+    std::vector<double> doubles(300000);
+    for (auto& x : doubles) x = static_cast<double>(rng() % 100000) / 7;
+    std::vector<double> expected = doubles;
+    std::sort(expected.begin() + 1000, expected.end() - 1000);
+    parallelMergeSort(doubles.data(), -2, 1000, static_cast<std::ptrdiff_t>(doubles.size()) - 1000, std::less<double>(), 4);
+    assert(doubles == expected);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_run_merger_tree() {
+    std::cout << "Testing the RunMerger tree..." << std::endl;
+
+    std::mt19937 rng(7);
+    for (std::ptrdiff_t runs : {2, 3, 17, 200}) {
+        std::ptrdiff_t n = 1 << 20;
+        std::vector<int> data(static_cast<std::size_t>(n));
+        for (auto& x : data) x = static_cast<int>(rng() % 100000);
+        std::vector<std::ptrdiff_t> run;
+        for (std::ptrdiff_t r = 0; r <= runs; ++r) run.push_back(n * r / runs);
+        for (std::ptrdiff_t r = 0; r < runs; ++r) std::sort(data.begin() + run[r], data.begin() + run[r + 1]);
+        std::vector<int> expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        for (int aim : {1, -1}) {
+            std::vector<int> a = data;
+            std::vector<int> b(a.size());
+            int* result = RunMerger<int, std::less<int>>::merge(a.data(), b.data(), 0, aim, run.data(), 0, runs, std::less<int>());
+            // A negative aim leaves the result in the buffer
+            assert(result == (aim > 0 ? a.data() : b.data()));
+            assert(std::vector<int>(result, result + n) == expected);
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_node_arena();
+    test_completion();
+    test_sorter_tree();
+    test_run_merger_tree();
+
+    std::cout << "All completer tests passed!" << std::endl;
+    return 0;
+}
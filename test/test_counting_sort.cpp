@@ -105,6 +105,47 @@ void test_duplicates(int size) {
     std::cout << "Passed." << std::endl;
 }
 
+template <typename T>
+void test_fill_run() {
+    std::cout << "Testing fill_run for every tail length... ";
+    for (bool vector : {false, true}) {
+        for (int n = 0; n <= 100; ++n) {
+            std::vector<T> arr(n + 2, static_cast<T>(1));
+            fill_run(arr.data() + 1, n, static_cast<T>(-2), vector);
+            for (int i = 0; i < n + 2; ++i) {
+                T expected = (i == 0 || i == n + 1) ? static_cast<T>(1) : static_cast<T>(-2);
+                if (arr[i] != expected) {
+                    std::cerr << "Test failed: fill_run wrote outside or missed the run!" << std::endl;
+                    exit(1);
+                }
+            }
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+template <typename T>
+void test_parallel(int size, int start, int end, int parallelism) {
+    std::cout << "Testing parallel counting sort of size " << size << " [" << start << ", " << end << ") with " << parallelism << " threads... ";
+    std::vector<T> arr(size), constant(size, static_cast<T>(3));
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    for (auto& val : arr) {
+        val = static_cast<T>(dist(rng));
+    }
+
+    for (std::vector<T>* data : {&arr, &constant}) {
+        std::vector<T> expected = *data;
+        std::sort(expected.begin() + start, expected.begin() + end);
+        parallel_counting_sort(data->data(), start, end, parallelism);
+        if (*data != expected) {
+            std::cerr << "Test failed: Parallel result does not match std::sort!" << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
 template <typename T>
 void run_tests_for_type(const std::string& type_name) {
     std::cout << "=== Testing type: " << type_name << " ===" << std::endl;
@@ -118,6 +159,7 @@ void run_tests_for_type(const std::string& type_name) {
     test_random<T>(129, 0, 129);
     test_random<T>(1000, 0, 1000);
     test_random<T>(66000, 0, 66000); // Larger than 2^16 for short tests
+    test_random<T>(300000, 3, 299999); // Interleaved sub-tables for both sizes
 
     // Sub-ranges
     test_random<T>(100, 20, 80);
@@ -127,6 +169,13 @@ void run_tests_for_type(const std::string& type_name) {
     test_reverse_sorted<T>(1000);
     test_duplicates<T>(1000);
 
+    test_fill_run<T>();
+
+    // Parallel counting, including a sub-range and a chunk count that does not divide the size
+    test_parallel<T>(1 << 20, 0, 1 << 20, 4);
+    test_parallel<T>(1000003, 17, 1000000, 3);
+    test_parallel<T>(1000, 0, 1000, 4); // Too small: sequential fallback
+
     std::cout << std::endl;
 }
 
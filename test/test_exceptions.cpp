@@ -0,0 +1,251 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+// Throws on the 'limit'-th comparison, counted over all threads
+struct ThrowingLess {
+    std::atomic<long>* calls;
+    long limit;
+    bool operator()(double x, double y) const {
+        if (calls->fetch_add(1, std::memory_order_relaxed) + 1 == limit) {
+            throw std::runtime_error("comparison failed");
+        }
+        return x < y;
+    }
+};
+
+std::vector<double> random_doubles(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<double> data(n);
+    for (auto& x : data) x = static_cast<double>(rng() % 1000000) / 3;
+    return data;
+}
+
+// Runs 'sort_call' with a comparator throwing on comparison 'limit'; true if it rethrew
+template<typename SortCall>
+bool throws_on_caller(std::vector<double>& data, long limit, SortCall sort_call) {
+    std::atomic<long> calls{0};
+    try {
+        sort_call(data, ThrowingLess{&calls, limit});
+    } catch (const std::runtime_error& e) {
+        assert(std::string(e.what()) == "comparison failed");
+        return true;
+    }
+    return false;
+}
+
+void test_pool() {
+    std::cout << "Testing exceptions of pool tasks..." << std::endl;
+
+    ThreadPool pool(4);
+    for (int round = 0; round < 50; ++round) {
+        TaskGroup group;
+        std::atomic<int> ran{0};
+        for (int i = 0; i < 200; ++i) {
+            pool.submit(group, [&ran, i] {
+                ran.fetch_add(1);
+                if (i == 10) throw std::logic_error("task " + std::to_string(i));
+            });
+        }
+        bool thrown = false;
+        try {
+            pool.wait(group);
+        } catch (const std::logic_error& e) {
+            thrown = std::string(e.what()) == "task 10";
+        }
+        assert(thrown);
+        assert(group.done());
+        // Tasks still queued when task 10 threw are dropped, even earlier ones
+        assert(ran.load() >= 1 && ran.load() <= 200);
+
+        // The group is reusable and no longer cancelled
+        assert(!group.cancelled());
+        pool.submit(group, [&ran] { ran.fetch_add(1000); });
+        pool.wait(group);
+        assert(ran.load() >= 1011);
+    }
+
+    // Only one exception reaches the waiter; dropped boxed tasks are released (checked under ASan)
+    TaskGroup group(2);
+    std::string text(100, 'x');
+    std::atomic<int> boxed_ran{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.submit(group, [text, &boxed_ran] {
+            boxed_ran.fetch_add(1);
+            throw std::runtime_error(text);
+        });
+    }
+    int caught = 0;
+    try {
+        pool.wait(group);
+    } catch (const std::runtime_error& e) {
+        caught += std::string(e.what()) == text;
+    }
+    assert(caught == 1);
+    assert(boxed_ran.load() >= 1 && boxed_ran.load() <= 100);
+    pool.submit(group, [text, &boxed_ran] { boxed_ran.fetch_add(1000); });
+    pool.wait(group);
+    assert(boxed_ran.load() >= 1001);
+
+    // Nested groups: an exception inside a parallel_for_chunks in a task reaches the outer waiter
+    TaskGroup outer;
+    pool.submit(outer, [&pool] {
+        parallel_for_chunks(pool, 8, [](int i) {
+            if (i == 5) throw std::out_of_range("chunk");
+        });
+    });
+    bool thrown = false;
+    try {
+        pool.wait(outer);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // The default group
+    pool.submit([] { throw std::runtime_error("default"); });
+    thrown = false;
+    try {
+        pool.wait_for_completion();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    pool.submit([] {});
+    pool.wait_for_completion();
+    assert(pool.get_thread_count() == 4);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sorts() {
+    std::cout << "Testing exceptions of comparators in parallel sorts..." << std::endl;
+
+    const std::size_t n = 400000;
+    auto& pool = getThreadPool(4);
+    std::size_t workers = pool.get_thread_count();
+
+    // Early, middle and late failures: in the run scan, the partitioning and the leaves
+    for (long limit : {10L, 200000L, 3000000L}) {
+        for (int round = 0; round < 3; ++round) {
+            std::vector<double> data = random_doubles(n, static_cast<unsigned>(limit + round));
+            std::vector<double> copy = data;
+
+            assert(throws_on_caller(copy, limit, [](std::vector<double>& v, ThrowingLess comp) {
+                sort(v.data(), 1, 0, static_cast<std::ptrdiff_t>(v.size()), comp);
+            }));
+            copy = data;
+            assert(throws_on_caller(copy, limit, [](std::vector<double>& v, ThrowingLess comp) {
+                sort(v.data(), 4, 0, static_cast<std::ptrdiff_t>(v.size()), comp);
+            }));
+            copy = data;
+            assert(throws_on_caller(copy, limit, [](std::vector<double>& v, ThrowingLess comp) {
+                parallelSampleSort(v.data(), 0, 0, static_cast<std::ptrdiff_t>(v.size()), comp, 4);
+            }));
+            copy = data;
+            assert(throws_on_caller(copy, limit, [](std::vector<double>& v, ThrowingLess comp) {
+                parallelMergeSort(v.data(), -2, 0, static_cast<std::ptrdiff_t>(v.size()), comp, 4);
+            }));
+            copy = data;
+            assert(throws_on_caller(copy, limit, [](std::vector<double>& v, ThrowingLess comp) {
+                stable_sort(v.data(), 4, 0, static_cast<std::ptrdiff_t>(v.size()), comp);
+            }));
+        }
+    }
+
+    // Sorted input fails in the parallel run merge
+    std::vector<double> sawtooth(n);
+    for (std::size_t i = 0; i < n; ++i) sawtooth[i] = static_cast<double>(i % 50000);
+    assert(throws_on_caller(sawtooth, 500000, [](std::vector<double>& v, ThrowingLess comp) {
+        sort(v.data(), 4, 0, static_cast<std::ptrdiff_t>(v.size()), comp);
+    }));
+
+    // The pool still sorts, with the same workers
+    for (int round = 0; round < 5; ++round) {
+        std::vector<double> data = random_doubles(n, static_cast<unsigned>(round));
+        std::vector<double> expected = data;
+        std::sort(expected.begin(), expected.end());
+        sort(data, 4, std::less<double>());
+        assert(data == expected);
+    }
+    assert(pool.get_thread_count() == workers);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_radix_scratch() {
+    std::cout << "Testing scratch exhaustion in a parallel radix sort..." << std::endl;
+
+    // 10% of the keys in one top bucket, sorted by a task, 90% in a bucket that
+    // takes another parallel pass after that task was submitted
+    const std::size_t n = std::size_t(1) << 20;
+    std::mt19937_64 rng(7);
+    std::vector<long> data(n);
+    for (auto& x : data) {
+        long bucket = (rng() % 10 == 0) ? 0 : 1;
+        x = (bucket << 40) | static_cast<long>(rng() & ((1UL << 40) - 1));
+    }
+
+    // Every worker is busy elsewhere, so the bucket tasks are still queued when
+    // the pass fails (the caller runs the chunks of the pass itself)
+    ThreadPool& pool = getThreadPool(4);
+    TaskGroup busy;
+    std::atomic<bool> release{false};
+    std::atomic<std::size_t> blocked{0};
+    for (std::size_t w = 0; w < pool.get_thread_count(); ++w) {
+        pool.submit(busy, [&release, &blocked] {
+            ++blocked;
+            while (!release.load()) std::this_thread::yield();
+        });
+    }
+    while (blocked.load() < pool.get_thread_count()) std::this_thread::yield();
+
+    // Room for the radix buffer and the histograms of the 4 threads only: the
+    // list of large buckets fails after the task of bucket 0 was submitted
+    std::vector<std::byte> memory(n * sizeof(long) + 4 * RADIX_BUCKETS * sizeof(std::ptrdiff_t));
+    ScratchArena arena(memory.data(), memory.size());
+    bool thrown = false;
+    try {
+        sort_with_resource(data, 4, &arena);
+    } catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(arena.used() == 0);
+
+    // No task of the sort runs after the exception reached the caller
+    std::vector<long> snapshot = data;
+    release = true;
+    pool.wait(busy);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(data == snapshot);
+    assert(pool.get_tasks_executed() == pool.get_tasks_pushed());
+
+    // With enough scratch memory the same input sorts
+    std::vector<long> expected = data;
+    std::sort(expected.begin(), expected.end());
+    std::vector<std::byte> enough(2 * n * sizeof(long));
+    ScratchArena large_arena(enough.data(), enough.size());
+    sort_with_resource(data, 4, &large_arena);
+    assert(data == expected);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_pool();
+    test_sorts();
+    test_radix_scratch();
+
+    std::cout << "All exception tests passed!" << std::endl;
+    return 0;
+}
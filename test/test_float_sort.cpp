@@ -9,6 +9,7 @@
 #include <iomanip>
 #include <cstring>
 #include "../include/dpqs/float_sort.hpp"
+#include "../include/dual_pivot_quicksort.hpp"
 
 // Mocking the sequential sorters if they are not fully linked or to isolate float_sort logic.
 // However, since we include float_sort.hpp which includes sequential_sorters.hpp,
@@ -141,8 +142,115 @@ void test_float_sort_logic(const std::string& type_name) {
     }
 }
 
+// Same values in the same order, telling -0.0 from +0.0 and any NaN from a number
+template <typename T>
+bool same_order(const std::vector<T>& x, const std::vector<T>& y) {
+    if (x.size() != y.size()) return false;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        if (std::isnan(x[i]) || std::isnan(y[i])) {
+            if (std::isnan(x[i]) != std::isnan(y[i])) return false;
+        } else if (x[i] != y[i] || std::signbit(x[i]) != std::signbit(y[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+std::vector<T> special_values(std::size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+    std::vector<T> arr(size);
+    for (auto& x : arr) {
+        switch (rng() % 10) {
+            case 0: x = std::numeric_limits<T>::quiet_NaN(); break;
+            case 1: x = T(-0.0); break;
+            case 2: x = T(0.0); break;
+            case 3: x = (rng() & 1) ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity(); break;
+            default: x = static_cast<T>(dist(rng)); break;
+        }
+    }
+    return arr;
+}
+
+template <typename T>
+void test_float_total_less(const std::string& type_name) {
+    std::cout << "Testing float_total_less for " << type_name << "..." << std::endl;
+    T nan = std::numeric_limits<T>::quiet_NaN();
+    T inf = std::numeric_limits<T>::infinity();
+    std::vector<T> ordered = {-inf, T(-1.0), T(-0.0), T(0.0), T(1.0), inf, nan};
+    for (std::size_t i = 0; i < ordered.size(); ++i) {
+        for (std::size_t j = 0; j < ordered.size(); ++j) {
+            assert(float_total_less(ordered[i], ordered[j]) == (i < j));
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+template <typename T>
+void test_parallel_sort_floats(const std::string& type_name) {
+    std::cout << "Testing parallel_sort_floats for " << type_name << "..." << std::endl;
+    // Sequential fallback, parallel sort only, and parallel NaN partition sizes
+    for (std::size_t size : {std::size_t(1000), std::size_t(50000), std::size_t(300000)}) {
+        for (int parallelism : {1, 2, 4}) {
+            std::vector<T> arr = special_values<T>(size, static_cast<unsigned>(size) + parallelism);
+            std::vector<T> expected = arr;
+            sort_floats(expected.data(), 0, static_cast<std::ptrdiff_t>(size));
+            parallel_sort_floats(arr.data(), 7, static_cast<std::ptrdiff_t>(size) - 7, parallelism);
+            std::sort(expected.begin(), expected.end(), float_total_less<T>);
+            std::vector<T> check = arr;
+            std::sort(check.begin() + 7, check.end() - 7, float_total_less<T>);
+            // The range is sorted, and the values around it stay put
+            assert(same_order(arr, check));
+        }
+    }
+
+    // Only NaNs, only zeros
+    std::vector<T> nans(100000, std::numeric_limits<T>::quiet_NaN());
+    parallel_sort_floats(nans.data(), 0, static_cast<std::ptrdiff_t>(nans.size()), 4);
+    for (T x : nans) assert(std::isnan(x));
+    std::vector<T> zeros(200000);
+    for (std::size_t i = 0; i < zeros.size(); ++i) zeros[i] = (i % 3 == 0) ? T(-0.0) : T(0.0);
+    std::vector<T> expected = zeros;
+    std::sort(expected.begin(), expected.end(), float_total_less<T>);
+    parallel_sort_floats(zeros.data(), 0, static_cast<std::ptrdiff_t>(zeros.size()), 4);
+    assert(same_order(zeros, expected));
+    std::cout << "Passed." << std::endl;
+}
+
+template <typename T>
+void test_sort_dispatch(const std::string& type_name) {
+    std::cout << "Testing dual_pivot::sort on special values for " << type_name << "..." << std::endl;
+    // std::less would call these sorted and return early
+    std::vector<T> nan_inside = {T(1.0), std::numeric_limits<T>::quiet_NaN(), T(0.0)};
+    dual_pivot::sort(nan_inside);
+    assert(nan_inside[0] == T(0.0) && nan_inside[1] == T(1.0) && std::isnan(nan_inside[2]));
+    std::vector<T> zeros = {T(0.0), T(-0.0)};
+    dual_pivot::sort(zeros);
+    assert(std::signbit(zeros[0]) && !std::signbit(zeros[1]));
+
+    for (std::size_t size : {std::size_t(3000), std::size_t(300000)}) {
+        for (int parallelism : {1, 4}) {
+            std::vector<T> arr = special_values<T>(size, 99);
+            std::vector<T> expected = arr;
+            std::sort(expected.begin(), expected.end(), float_total_less<T>);
+            dual_pivot::sort(arr, parallelism);
+            assert(same_order(arr, expected));
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
 int main() {
     test_float_sort_logic<float>("float");
     test_float_sort_logic<double>("double");
+
+    test_float_total_less<float>("float");
+    test_float_total_less<long double>("long double");
+    test_parallel_sort_floats<double>("double");
+    test_parallel_sort_floats<long double>("long double");
+    test_sort_dispatch<float>("float");
+    test_sort_dispatch<double>("double");
+    test_sort_dispatch<long double>("long double");
     return 0;
 }
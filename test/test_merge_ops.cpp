@@ -4,6 +4,11 @@
 #include <random>
 #include <cassert>
 #include <string>
+#include <numeric>
+#include <functional>
+#include <utility>
+#include <limits>
+#include <cstring>
 #include "dpqs/merge_ops.hpp"
 
 using namespace dual_pivot;
@@ -45,7 +50,7 @@ void test_merge_parts() {
         std::vector<int> src2 = {2, 4, 6, 8, 10};
         std::vector<int> dst(10);
         
-        merge_parts(dst.data(), 0, src1.data(), 0, 5, src2.data(), 0, 5);
+        merge_parts(dst.data(), 0, src1.data(), 0, 5, src2.data(), 0, 5, std::less<int>());
         
         assert(is_sorted(dst));
         for(int i=0; i<10; ++i) assert(dst[i] == i+1);
@@ -76,40 +81,187 @@ void test_merge_parts() {
         // lo1=0, hi1=5, lo2=5, hi2=10
         // dst = arr
         
-        merge_parts(arr.data(), 0, aux.data(), 0, 5, aux.data(), 5, 10);
+        merge_parts(arr.data(), 0, aux.data(), 0, 5, aux.data(), 5, 10, std::less<int>());
         assert(is_sorted(arr));
     }
 
     std::cout << "Passed." << std::endl;
 }
 
+// Merges src1 and src2 with Kernel, out of place and in place (into the array
+// holding the second segment, as the run merger does), and compares the bytes
+// with the comparator kernel
+template<typename Kernel, typename T>
+void check_kernel(std::vector<T> src1, std::vector<T> src2) {
+    std::ptrdiff_t n1 = static_cast<std::ptrdiff_t>(src1.size());
+    std::ptrdiff_t n2 = static_cast<std::ptrdiff_t>(src2.size());
+    std::vector<T> expected(n1 + n2), dst(n1 + n2);
+    merge_parts_with<ComparatorMergeKernel>(expected.data(), 0, src1.data(), 0, n1, src2.data(), 0, n2, std::less<T>());
+    merge_parts_with<Kernel>(dst.data(), 0, src1.data(), 0, n1, src2.data(), 0, n2, std::less<T>());
+    assert(expected.empty() || std::memcmp(dst.data(), expected.data(), sizeof(T) * expected.size()) == 0);
+
+    std::vector<T> in_place(n1 + n2);
+    std::copy(src2.begin(), src2.end(), in_place.begin() + n1);
+    merge_parts_with<Kernel>(in_place.data(), 0, src1.data(), 0, n1, in_place.data(), n1, n1 + n2, std::less<T>());
+    assert(expected.empty() || std::memcmp(in_place.data(), expected.data(), sizeof(T) * expected.size()) == 0);
+}
+
+template<typename Kernel, typename T>
+void check_kernel_patterns(std::mt19937_64& rng) {
+    // Sizes around the 8-key vector blocks, then large ones
+    for (std::size_t n1 : {0, 1, 7, 8, 9, 16, 17, 33, 100, 5000}) {
+        for (std::size_t n2 : {0, 1, 8, 15, 16, 24, 99, 4099}) {
+            for (unsigned range : {3u, 1000u, 0u}) {
+                std::vector<T> src1(n1), src2(n2);
+                for (auto& x : src1) x = static_cast<T>(range ? rng() % range : rng());
+                for (auto& x : src2) x = static_cast<T>(range ? rng() % range : rng());
+                std::sort(src1.begin(), src1.end());
+                std::sort(src2.begin(), src2.end());
+                check_kernel<Kernel>(src1, src2);
+            }
+        }
+    }
+    // Extremes and disjoint segments
+    std::vector<T> low(1000, std::numeric_limits<T>::lowest()), high(1000, std::numeric_limits<T>::max());
+    low.back() = T(0);
+    check_kernel<Kernel>(low, high);
+    check_kernel<Kernel>(high, low);
+}
+
+void test_merge_kernels() {
+    std::cout << "Testing merge kernels..." << std::endl;
+
+    std::mt19937_64 rng(17);
+    check_kernel_patterns<BranchlessMergeKernel, int>(rng);
+    check_kernel_patterns<BranchlessMergeKernel, long>(rng);
+    check_kernel_patterns<BranchlessMergeKernel, unsigned char>(rng);
+    check_kernel_patterns<BranchlessMergeKernel, double>(rng);
+
+    // NaNs compare false in both kernels, so they take the same path
+    std::vector<double> with_nan1 = {1.0, std::numeric_limits<double>::quiet_NaN(), 2.0, -0.0};
+    std::vector<double> with_nan2 = {0.0, 1.0, std::numeric_limits<double>::quiet_NaN(), 3.0};
+    check_kernel<BranchlessMergeKernel>(with_nan1, with_nan2);
+
+#if DPQS_HAS_X86_SIMD
+    if (simd_level() != SimdLevel::None) {
+        check_kernel_patterns<Avx2BitonicMergeKernel, int>(rng);
+        check_kernel_patterns<Avx2BitonicMergeKernel, unsigned>(rng);
+    }
+#endif
+    std::cout << "Passed." << std::endl;
+}
+
+void test_merge_path_split() {
+    std::cout << "Testing merge_path_split..." << std::endl;
+
+    // The co-rank of every output position matches the element sources of merge_parts
+    std::mt19937 rng(1);
+    for (int round = 0; round < 50; ++round) {
+        std::ptrdiff_t n1 = rng() % 40;
+        std::ptrdiff_t n2 = rng() % 40;
+        std::vector<std::pair<int, int>> src1(n1), src2(n2);
+        for (std::ptrdiff_t i = 0; i < n1; ++i) src1[i] = {static_cast<int>(rng() % 10), 1};
+        for (std::ptrdiff_t i = 0; i < n2; ++i) src2[i] = {static_cast<int>(rng() % 10), 2};
+        auto by_key = [](const std::pair<int, int>& x, const std::pair<int, int>& y) { return x.first < y.first; };
+        std::sort(src1.begin(), src1.end(), by_key);
+        std::sort(src2.begin(), src2.end(), by_key);
+
+        std::vector<std::pair<int, int>> dst(n1 + n2);
+        merge_parts(dst.data(), 0, src1.data(), 0, n1, src2.data(), 0, n2, by_key);
+        std::ptrdiff_t from_first = 0;
+        for (std::ptrdiff_t i = 0; i <= n1 + n2; ++i) {
+            assert(merge_path_split(i, src1.data(), 0, n1, src2.data(), 0, n2, by_key) == from_first);
+            if (i < n1 + n2 && dst[i].second == 1) ++from_first;
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+// parallel_merge_parts must give exactly the result of merge_parts
+template<typename T, typename Compare = std::less<T>>
+void check_parallel_merge(const std::vector<T>& src1, const std::vector<T>& src2, Compare comp = Compare()) {
+    std::ptrdiff_t n1 = static_cast<std::ptrdiff_t>(src1.size());
+    std::ptrdiff_t n2 = static_cast<std::ptrdiff_t>(src2.size());
+    std::vector<T> expected(n1 + n2 + 2);
+    std::vector<T> dst(n1 + n2 + 2);
+    std::vector<T> a1 = src1, a2 = src2;
+    merge_parts(expected.data(), 1, a1.data(), 0, n1, a2.data(), 0, n2, comp);
+    parallel_merge_parts(dst.data(), 1, a1.data(), 0, n1, a2.data(), 0, n2, comp);
+    assert(dst == expected);
+}
+
 void test_parallel_merge_parts() {
     std::cout << "Testing parallel_merge_parts..." << std::endl;
-    
-    // Large arrays to trigger parallelism
-    int size = 20000; // MIN_PARALLEL_MERGE_PARTS_SIZE is likely 4096 or similar
+    getThreadPool(4);
+
+    // Interleaved halves
+    int size = 200000;
     std::vector<int> src1(size);
     std::vector<int> src2(size);
     std::vector<int> dst(size * 2);
-    
-    std::iota(src1.begin(), src1.end(), 0);
-    for(auto& x : src1) x *= 2; // 0, 2, 4...
-    
-    std::iota(src2.begin(), src2.end(), 0);
-    for(auto& x : src2) x = x * 2 + 1; // 1, 3, 5...
-    
-    parallel_merge_parts(dst.data(), 0, src1.data(), 0, size, src2.data(), 0, size);
-    
+    for (int i = 0; i < size; ++i) {
+        src1[i] = 2 * i;
+        src2[i] = 2 * i + 1;
+    }
+    parallel_merge_parts(dst.data(), 0, src1.data(), 0, size, src2.data(), 0, size, std::less<int>());
     assert(is_sorted(dst));
-    for(int i=0; i<size*2; ++i) assert(dst[i] == i);
-    
+    for (int i = 0; i < size * 2; ++i) assert(dst[i] == i);
+
+    std::mt19937 rng(42);
+    auto sorted_random = [&](std::size_t n, unsigned range) {
+        std::vector<long> v(n);
+        for (auto& x : v) x = static_cast<long>(rng() % range);
+        std::sort(v.begin(), v.end());
+        return v;
+    };
+    // Random, many duplicates, all equal, disjoint, and very unequal sizes
+    check_parallel_merge(sorted_random(300000, 1u << 30), sorted_random(250001, 1u << 30));
+    check_parallel_merge(sorted_random(300000, 16), sorted_random(300000, 16));
+    check_parallel_merge(std::vector<long>(200000, 5), std::vector<long>(200000, 5));
+    std::vector<long> low(200000), high(200000);
+    std::iota(low.begin(), low.end(), 0L);
+    std::iota(high.begin(), high.end(), 1000000L);
+    check_parallel_merge(high, low);
+    check_parallel_merge(low, high);
+    check_parallel_merge(sorted_random(400000, 1000), sorted_random(10, 1000));
+    check_parallel_merge(std::vector<long>(), sorted_random(300000, 1000));
+
+    // Ties keep the order of merge_parts (the second segment first)
+    std::vector<std::pair<int, int>> tagged1(200000), tagged2(200000);
+    for (int i = 0; i < 200000; ++i) {
+        tagged1[i] = {i / 7, 1};
+        tagged2[i] = {i / 5, 2};
+    }
+    check_parallel_merge(tagged1, tagged2, [](const std::pair<int, int>& x, const std::pair<int, int>& y) {
+        return x.first < y.first;
+    });
+
+    // Descending order
+    std::vector<long> desc1 = sorted_random(200000, 5000), desc2 = sorted_random(200000, 5000);
+    std::reverse(desc1.begin(), desc1.end());
+    std::reverse(desc2.begin(), desc2.end());
+    check_parallel_merge(desc1, desc2, std::greater<long>());
+
+    // Destination overlapping the second segment (merged in place, sequentially)
+    std::vector<long> first = sorted_random(150000, 100000);
+    std::vector<long> in_place(300000);
+    std::vector<long> second = sorted_random(150000, 100000);
+    std::copy(second.begin(), second.end(), in_place.begin() + 150000);
+    std::vector<long> expected_in_place = first;
+    expected_in_place.insert(expected_in_place.end(), second.begin(), second.end());
+    std::sort(expected_in_place.begin(), expected_in_place.end());
+    parallel_merge_parts(in_place.data(), 0, first.data(), 0, 150000, in_place.data(), 150000, 300000, std::less<long>());
+    assert(in_place == expected_in_place);
+
     std::cout << "Passed." << std::endl;
 }
 
 int main() {
     test_merge_parts();
+    test_merge_kernels();
+    test_merge_path_split();
     test_parallel_merge_parts();
-    
+
     std::cout << "All merge ops tests passed!" << std::endl;
     return 0;
 }
@@ -1,10 +1,16 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <numeric>
 #include <random>
 #include <cassert>
 #include <string>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "dpqs/partition.hpp"
+#include "dpqs/parallel/parallel_partition.hpp"
 
 using namespace dual_pivot;
 
@@ -38,7 +44,7 @@ void test_partition_dual_pivot() {
         // partition_dual_pivot(T* a, int low, int high, int pivotIndex1, int pivotIndex2)
         // It extracts pivots from a[pivotIndex1] and a[pivotIndex2].
 
-        auto res = partition_dual_pivot(arr.data(), 0, arr.size(), 0, 1);
+        auto res = partition_dual_pivot(arr.data(), 0, arr.size(), 0, 1, std::less<int>());
         int lower = res.first;
         int upper = res.second;
 
@@ -58,7 +64,7 @@ void test_partition_dual_pivot() {
         }
 
         // (upper, high) > p2
-        for (int i = upper + 1; i < arr.size(); ++i) {
+        for (int i = upper + 1; i < static_cast<int>(arr.size()); ++i) {
             assert(arr[i] > p2);
         }
     }
@@ -79,7 +85,7 @@ void test_partition_single_pivot() {
         int p = arr[0];
 
         // partition_single_pivot(T* a, int low, int high, int pivotIndex1, int)
-        auto res = partition_single_pivot(arr.data(), 0, arr.size(), 0, 0);
+        auto res = partition_single_pivot(arr.data(), 0, arr.size(), 0, 0, std::less<int>());
         int lower = res.first;
         int upper = res.second;
 
@@ -89,8 +95,8 @@ void test_partition_single_pivot() {
             assert(arr[i] < p);
         }
 
-        // [lower, upper) == p
-        for (int i = lower; i < upper; ++i) {
+        // [lower, upper] == p (inclusive bounds of the equal range)
+        for (int i = lower; i <= upper; ++i) {
             if (arr[i] != p) {
                 std::cout << "Failed at middle part index " << i << ": " << arr[i] << " != " << p << std::endl;
                 print_array(arr);
@@ -99,8 +105,8 @@ void test_partition_single_pivot() {
             }
         }
 
-        // [upper, high) > p
-        for (int i = upper; i < arr.size(); ++i) {
+        // (upper, high) > p
+        for (int i = upper + 1; i < static_cast<int>(arr.size()); ++i) {
             if (arr[i] <= p) {
                 std::cout << "Failed at right part index " << i << ": " << arr[i] << " <= " << p << std::endl;
                 print_array(arr);
@@ -113,9 +119,249 @@ void test_partition_single_pivot() {
     std::cout << "Passed." << std::endl;
 }
 
+// Checks the [ < P1 | P1 <= x <= P2 | > P2 ] layout produced by a dual-pivot kernel
+template<typename T>
+void check_dual_pivot_layout(const std::vector<T>& arr, std::ptrdiff_t lower, std::ptrdiff_t upper, T p1, T p2) {
+    assert(arr[lower] == p1);
+    assert(arr[upper] == p2);
+    for (std::ptrdiff_t i = 0; i < lower; ++i) {
+        assert(arr[i] < p1);
+    }
+    for (std::ptrdiff_t i = lower + 1; i < upper; ++i) {
+        assert(arr[i] >= p1 && arr[i] <= p2);
+    }
+    for (std::ptrdiff_t i = upper + 1; i < static_cast<std::ptrdiff_t>(arr.size()); ++i) {
+        assert(arr[i] > p2);
+    }
+}
+
+template<typename T>
+void run_block_partition_case(std::vector<T> arr, std::ptrdiff_t i1, std::ptrdiff_t i2) {
+    if (arr[i2] < arr[i1]) std::swap(arr[i1], arr[i2]);
+    T p1 = arr[i1];
+    T p2 = arr[i2];
+
+    std::vector<T> classic = arr;
+    auto expected = partition_dual_pivot(classic.data(), 0, classic.size(), i1, i2, std::less<T>());
+    auto res = partition_dual_pivot_block(arr.data(), 0, arr.size(), i1, i2, std::less<T>());
+
+    // Both kernels must agree on the partition boundaries
+    assert(res == expected);
+    check_dual_pivot_layout(arr, res.first, res.second, p1, p2);
+
+    // Partitioning must be a permutation
+    std::sort(arr.begin(), arr.end());
+    std::sort(classic.begin(), classic.end());
+    assert(arr == classic);
+}
+
+void test_partition_dual_pivot_block() {
+    std::cout << "Testing partition_dual_pivot_block..." << std::endl;
+
+    std::mt19937 g(321);
+
+    // Sizes around the block length, random and duplicate-heavy values
+    for (int n : {2, 3, 10, 127, 128, 129, 130, 257, 1000, 5000}) {
+        std::uniform_int_distribution<int> wide(-100000, 100000);
+        std::uniform_int_distribution<int> narrow(0, 5);
+        std::vector<int> random_ints(n), dup_ints(n);
+        for (auto& x : random_ints) x = wide(g);
+        for (auto& x : dup_ints) x = narrow(g);
+
+        run_block_partition_case(random_ints, 0, n - 1);
+        run_block_partition_case(random_ints, n / 3, (2 * n) / 3);
+        run_block_partition_case(dup_ints, n / 3, (2 * n) / 3);
+
+        std::uniform_real_distribution<double> real(-1.0, 1.0);
+        std::vector<double> doubles(n);
+        for (auto& x : doubles) x = real(g);
+        run_block_partition_case(doubles, n / 4, (3 * n) / 4);
+    }
+
+    // Sorted and reverse sorted input
+    {
+        std::vector<long> sorted(1000);
+        std::iota(sorted.begin(), sorted.end(), 0L);
+        run_block_partition_case(sorted, 300, 600);
+        std::reverse(sorted.begin(), sorted.end());
+        run_block_partition_case(sorted, 300, 600);
+    }
+
+    // The dispatcher picks the block kernel for std::less on arithmetic types
+    static_assert(use_block_partition_v<int, std::less<int>>);
+    static_assert(use_block_partition_v<double, std::less<>>);
+    static_assert(!use_block_partition_v<std::string, std::less<std::string>>);
+
+    std::cout << "Passed." << std::endl;
+}
+
+// Runs one SIMD classifier against the classic kernel on the same input
+template<typename T, typename Classifier>
+void run_simd_partition_case(std::vector<T> arr, std::ptrdiff_t i1, std::ptrdiff_t i2) {
+    if (arr[i2] < arr[i1]) std::swap(arr[i1], arr[i2]);
+    std::vector<T> classic = arr;
+    auto expected = partition_dual_pivot(classic.data(), 0, classic.size(), i1, i2, std::less<T>());
+    auto res = partition_dual_pivot_block<T, std::less<T>, Classifier>(arr.data(), 0, arr.size(), i1, i2, std::less<T>());
+    assert(res == expected);
+    // Same boundaries and same elements in each region (NaNs grouped last)
+    auto canonical = [](std::vector<T>& v, std::ptrdiff_t from, std::ptrdiff_t to) {
+        auto mid = std::partition(v.begin() + from, v.begin() + to, [](T x) { return x == x; });
+        std::sort(v.begin() + from, mid);
+    };
+    for (auto* v : {&arr, &classic}) {
+        canonical(*v, 0, res.first);
+        canonical(*v, res.first + 1, res.second);
+        canonical(*v, res.second + 1, v->size());
+    }
+    for (size_t i = 0; i < arr.size(); ++i) {
+        assert(arr[i] == classic[i] || (arr[i] != arr[i] && classic[i] != classic[i]));
+    }
+}
+
+template<typename T, typename Classifier>
+void run_simd_partition_type(std::mt19937& g) {
+    for (int n : {3, 17, 128, 129, 1000, 4099}) {
+        std::vector<T> arr(n);
+        for (auto& x : arr) {
+            if constexpr (std::is_floating_point_v<T>) {
+                x = static_cast<T>(std::uniform_real_distribution<double>(-1e6, 1e6)(g));
+            } else {
+                x = static_cast<T>(g());
+            }
+        }
+        run_simd_partition_case<T, Classifier>(arr, n / 3, (2 * n) / 3);
+        for (auto& x : arr) x = static_cast<T>(g() % 4);
+        run_simd_partition_case<T, Classifier>(arr, n / 3, (2 * n) / 3);
+    }
+}
+
+template<typename Classifier>
+void run_simd_partition_types() {
+    std::mt19937 g(99);
+    run_simd_partition_type<int, Classifier>(g);
+    run_simd_partition_type<unsigned int, Classifier>(g);
+    run_simd_partition_type<long, Classifier>(g);
+    run_simd_partition_type<unsigned long long, Classifier>(g);
+    run_simd_partition_type<float, Classifier>(g);
+    run_simd_partition_type<double, Classifier>(g);
+
+    // NaN elements are neither less nor greater than a pivot, like operator<
+    std::vector<double> with_nan(300);
+    for (size_t i = 0; i < with_nan.size(); ++i) {
+        with_nan[i] = (i % 7 == 0) ? std::nan("") : static_cast<double>((i * 37) % 101);
+    }
+    with_nan[100] = 20.0;
+    with_nan[200] = 80.0;
+    run_simd_partition_case<double, Classifier>(with_nan, 100, 200);
+}
+
+void test_partition_dual_pivot_simd() {
+    std::cout << "Testing SIMD block classifiers..." << std::endl;
+#if DPQS_HAS_X86_SIMD
+    if (simd_level() >= SimdLevel::AVX2) {
+        run_simd_partition_types<Avx2BlockClassifier>();
+    } else {
+        std::cout << "AVX2 not available, skipped." << std::endl;
+    }
+    if (simd_level() >= SimdLevel::AVX512) {
+        run_simd_partition_types<Avx512BlockClassifier>();
+    } else {
+        std::cout << "AVX-512 not available, skipped." << std::endl;
+    }
+#else
+    std::cout << "SIMD kernels not compiled, skipped." << std::endl;
+#endif
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T>
+void run_parallel_partition_case(ThreadPool& pool, std::vector<T> arr, std::ptrdiff_t i1, std::ptrdiff_t i2, int chunks) {
+    if (arr[i2] < arr[i1]) std::swap(arr[i1], arr[i2]);
+    T p1 = arr[i1];
+    T p2 = arr[i2];
+    T median = arr[(i1 + i2) / 2];
+
+    std::vector<T> single = arr;
+    std::vector<T> classic = arr;
+    auto expected = partition_dual_pivot(classic.data(), 0, classic.size(), i1, i2, std::less<T>());
+    auto res = parallel_partition_dual_pivot(arr.data(), 0, arr.size(), i1, i2, std::less<T>(), pool, chunks);
+
+    // Boundaries only depend on the element counts, so they match the sequential kernel
+    assert(res == expected);
+    check_dual_pivot_layout(arr, res.first, res.second, p1, p2);
+    std::sort(arr.begin(), arr.end());
+    std::sort(classic.begin(), classic.end());
+    assert(arr == classic);
+
+    std::vector<T> single_seq = single;
+    auto expected_single = partition_single_pivot(single_seq.data(), 0, single_seq.size(), (i1 + i2) / 2, 0, std::less<T>());
+    auto res_single = parallel_partition_single_pivot(single.data(), 0, single.size(), (i1 + i2) / 2, std::less<T>(), pool, chunks);
+    assert(res_single == expected_single);
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(single.size()); ++i) {
+        if (i < res_single.first) assert(single[i] < median);
+        else if (i <= res_single.second) assert(!(single[i] < median) && !(median < single[i]));
+        else assert(median < single[i]);
+    }
+}
+
+void test_parallel_partition() {
+    std::cout << "Testing parallel partitioning..." << std::endl;
+
+    ThreadPool pool(3);
+    std::mt19937 g(99);
+
+    // Tiny chunks (down to a few elements), chunks around the block length and large ones
+    for (int n : {3, 10, 100, 1000, 20000, 300000}) {
+        for (int chunks : {2, 3, 5, 8}) {
+            std::vector<int> random(n);
+            for (auto& x : random) x = static_cast<int>(g() % 100000);
+            run_parallel_partition_case(pool, random, n / 4, n * 3 / 4, chunks);
+
+            std::vector<int> dups(n);
+            for (auto& x : dups) x = static_cast<int>(g() % 4);
+            run_parallel_partition_case(pool, dups, 0, n - 1, chunks);
+
+            std::vector<double> sorted(n);
+            std::iota(sorted.begin(), sorted.end(), 0.0);
+            run_parallel_partition_case(pool, sorted, n / 3, n * 2 / 3, chunks);
+        }
+    }
+
+    // Element types without a SIMD kernel use the scalar classifier
+    std::vector<short> shorts(20000);
+    for (auto& x : shorts) x = static_cast<short>(g() % 1000);
+    run_parallel_partition_case(pool, shorts, 5000, 15000, 4);
+
+    // Non-trivially copyable elements have no block kernel and are partitioned sequentially
+    std::vector<std::string> words(5000);
+    for (auto& w : words) w = std::to_string(g() % 1000);
+    run_parallel_partition_case(pool, words, 100, 4000, 4);
+
+    // Chunks forked inside a task count against the budget of that task's group
+    TaskGroup sort_group(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    pool.submit(sort_group, [&] {
+        parallel_for_chunks(pool, 8, [&](int) {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            --running;
+        });
+    });
+    pool.wait(sort_group);
+    assert(peak.load() >= 1 && peak.load() <= 2);
+
+    std::cout << "Passed." << std::endl;
+}
+
 int main() {
     test_partition_dual_pivot();
     test_partition_single_pivot();
+    test_partition_dual_pivot_block();
+    test_partition_dual_pivot_simd();
+    test_parallel_partition();
 
     std::cout << "All partition tests passed!" << std::endl;
     return 0;
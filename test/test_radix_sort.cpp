@@ -0,0 +1,222 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+// Order of sort_floats: -0.0 before +0.0, NaNs last
+template<typename T>
+bool total_less(T x, T y) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(x)) return false;
+        if (std::isnan(y)) return true;
+        if (x == y) return std::signbit(x) && !std::signbit(y);
+    }
+    return x < y;
+}
+
+template<typename T>
+bool same(const std::vector<T>& x, const std::vector<T>& y) {
+    if (x.size() != y.size()) return false;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(x[i]) && std::isnan(y[i])) continue;
+            if (std::signbit(x[i]) != std::signbit(y[i])) return false;
+        }
+        if (!(x[i] == y[i])) return false;
+    }
+    return true;
+}
+
+template<typename T>
+void check_radix(std::vector<T> data, int parallelism) {
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), total_less<T>);
+    radix_sort(data.data(), 0, static_cast<std::ptrdiff_t>(data.size()), parallelism);
+    assert(same(data, expected));
+}
+
+void test_radix_key() {
+    std::cout << "Testing RadixKey order..." << std::endl;
+
+    std::vector<int> ints = {std::numeric_limits<int>::min(), -1000, -1, 0, 1, 255, 256, std::numeric_limits<int>::max()};
+    for (std::size_t i = 0; i + 1 < ints.size(); ++i) {
+        assert(RadixKey<int>::of(ints[i]) < RadixKey<int>::of(ints[i + 1]));
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> doubles = {-inf, -1e300, -1.0, -std::numeric_limits<double>::denorm_min(), -0.0, 0.0,
+                                   std::numeric_limits<double>::denorm_min(), 1.0, 1e300, inf};
+    for (std::size_t i = 0; i + 1 < doubles.size(); ++i) {
+        assert(RadixKey<double>::of(doubles[i]) < RadixKey<double>::of(doubles[i + 1]));
+    }
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    assert(RadixKey<double>::of(inf) < RadixKey<double>::of(nan));
+    assert(RadixKey<double>::of(-nan) == RadixKey<double>::of(nan));
+    assert(RadixKey<float>::of(-0.0f) < RadixKey<float>::of(0.0f));
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T>
+void check_patterns(std::size_t n, int parallelism, std::mt19937_64& rng) {
+    std::vector<T> random(n), few(n), sorted(n), reversed(n);
+    for (auto& x : random) x = static_cast<T>(rng());
+    for (auto& x : few) x = static_cast<T>(rng() % 7);
+    for (std::size_t i = 0; i < n; ++i) {
+        sorted[i] = static_cast<T>(i);
+        reversed[i] = static_cast<T>(n - i);
+    }
+    check_radix(random, parallelism);
+    check_radix(few, parallelism);
+    check_radix(sorted, parallelism);
+    check_radix(reversed, parallelism);
+    check_radix(std::vector<T>(n, static_cast<T>(42)), parallelism);
+}
+
+void test_integers() {
+    std::cout << "Testing radix_sort on integers..." << std::endl;
+
+    std::mt19937_64 rng(11);
+    // Comparison sort, LSD only, MSD + LSD, and parallel sizes
+    for (std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(2), std::size_t(200), std::size_t(5000),
+                          std::size_t(70001), std::size_t(300007)}) {
+        for (int parallelism : {1, 2, 4}) {
+            check_patterns<int>(n, parallelism, rng);
+            check_patterns<long>(n, parallelism, rng);
+            check_patterns<unsigned>(n, parallelism, rng);
+            check_patterns<unsigned long>(n, parallelism, rng);
+        }
+    }
+
+    // Timestamps: the high bytes are the same for every key
+    std::vector<long> timestamps(400000);
+    for (auto& x : timestamps) x = 1700000000000L + static_cast<long>(rng() % 86400000);
+    check_radix(timestamps, 1);
+    check_radix(timestamps, 4);
+
+    // Skewed: almost every key falls into one top-digit bucket
+    std::vector<int> skewed(1 << 20);
+    for (auto& x : skewed) x = (rng() % 100 == 0) ? -static_cast<int>(rng() % 1000) : static_cast<int>(rng() % (1 << 23));
+    check_radix(skewed, 1);
+    check_radix(skewed, 4);
+
+    // Negative and positive extremes
+    std::vector<long> extremes = {std::numeric_limits<long>::max(), -1, std::numeric_limits<long>::min(), 0, 1};
+    extremes.resize(3000, std::numeric_limits<long>::min());
+    check_radix(extremes, 1);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_floating_point() {
+    std::cout << "Testing radix_sort on float and double..." << std::endl;
+
+    std::mt19937_64 rng(5);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    for (std::size_t n : {std::size_t(100), std::size_t(20000), std::size_t(300000)}) {
+        for (int parallelism : {1, 4}) {
+            std::vector<double> doubles(n);
+            std::vector<float> floats(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                double x = std::normal_distribution<double>(0.0, 1e6)(rng);
+                switch (rng() % 16) {
+                    case 0: x = nan; break;
+                    case 1: x = -nan; break;
+                    case 2: x = 0.0; break;
+                    case 3: x = -0.0; break;
+                    case 4: x = (rng() & 1) ? inf : -inf; break;
+                    default: break;
+                }
+                doubles[i] = x;
+                floats[i] = static_cast<float>(x);
+            }
+            check_radix(doubles, parallelism);
+            check_radix(floats, parallelism);
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_subrange() {
+    std::cout << "Testing radix_sort on a subrange..." << std::endl;
+
+    std::mt19937_64 rng(9);
+    std::vector<long> data(300000);
+    for (auto& x : data) x = static_cast<long>(rng());
+    for (int parallelism : {1, 4}) {
+        std::vector<long> ranged = data;
+        std::vector<long> expected = data;
+        std::sort(expected.begin() + 1000, expected.end() - 1000);
+        radix_sort(ranged.data(), 1000, static_cast<std::ptrdiff_t>(ranged.size()) - 1000, parallelism);
+        assert(ranged == expected);
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sort_dispatch() {
+    std::cout << "Testing sort() above RADIX_SORT_THRESHOLD..." << std::endl;
+
+    std::mt19937_64 rng(3);
+    std::vector<long> longs(static_cast<std::size_t>(RADIX_SORT_THRESHOLD) * 50 + 7);
+    for (auto& x : longs) x = static_cast<long>(rng());
+    std::vector<long> expected = longs;
+    std::sort(expected.begin(), expected.end());
+    std::vector<long> parallel = longs;
+    sort(longs);
+    sort(parallel, 4);
+    assert(longs == expected);
+    assert(parallel == expected);
+
+    // NaNs and signed zeros keep the sort_floats order on the radix path
+    std::vector<double> doubles(static_cast<std::size_t>(RADIX_SORT_THRESHOLD) * 2);
+    for (auto& x : doubles) x = static_cast<double>(static_cast<int>(rng() % 200) - 100);
+    doubles[5] = std::numeric_limits<double>::quiet_NaN();
+    doubles[17] = -0.0;
+    std::vector<double> expected_doubles = doubles;
+    std::sort(expected_doubles.begin(), expected_doubles.end(), total_less<double>);
+    sort(doubles);
+    assert(same(doubles, expected_doubles));
+    assert(std::isnan(doubles.back()));
+
+    // A few ascending and descending runs take the run merger instead
+    for (int runs : {2, 5, 40}) {
+        std::vector<int> ints(static_cast<std::size_t>(RADIX_SORT_THRESHOLD) * 64);
+        for (auto& x : ints) x = static_cast<int>(rng());
+        for (int r = 0; r < runs; ++r) {
+            auto first = ints.begin() + ints.size() * r / runs;
+            auto last = ints.begin() + ints.size() * (r + 1) / runs;
+            std::sort(first, last);
+            if (r % 2 == 1) std::reverse(first, last);
+        }
+        std::vector<unsigned> unsigneds(ints.begin(), ints.end());
+        std::vector<int> parallel_ints = ints;
+        std::vector<int> expected_ints = ints;
+        std::vector<unsigned> expected_unsigneds = unsigneds;
+        std::sort(expected_ints.begin(), expected_ints.end());
+        std::sort(expected_unsigneds.begin(), expected_unsigneds.end());
+        sort(ints, 1);
+        sort(unsigneds, 1);
+        sort(parallel_ints, 4);
+        assert(ints == expected_ints);
+        assert(unsigneds == expected_unsigneds);
+        assert(parallel_ints == expected_ints);
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_radix_key();
+    test_integers();
+    test_floating_point();
+    test_subrange();
+    test_sort_dispatch();
+
+    std::cout << "All radix sort tests passed!" << std::endl;
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <numeric>
+#include <functional>
 #include <cassert>
 #include <string>
 #include "dpqs/run_merger.hpp"
@@ -38,7 +40,7 @@ void test_try_merge_runs() {
         };
         // try_merge_runs should detect these runs, reverse the descending one, and merge them.
 
-        bool merged = try_merge_runs(arr.data(), 0, arr.size());
+        bool merged = try_merge_runs(arr.data(), 0, static_cast<std::ptrdiff_t>(arr.size()), std::less<int>());
 
         if (merged) {
             std::cout << "Runs detected and merged." << std::endl;
@@ -64,7 +66,7 @@ void test_try_merge_runs() {
         // Run 3: 100..149
         for(int i=0; i<run_len; ++i) arr.push_back(100 + i);
 
-        bool merged = try_merge_runs(arr.data(), 0, arr.size());
+        bool merged = try_merge_runs(arr.data(), 0, static_cast<std::ptrdiff_t>(arr.size()), std::less<int>());
 
         if (merged) {
             assert(is_sorted(arr));
@@ -80,7 +82,7 @@ void test_try_merge_runs() {
         std::mt19937 g(123);
         std::shuffle(arr.begin(), arr.end(), g);
 
-        bool merged = try_merge_runs(arr.data(), 0, arr.size());
+        bool merged = try_merge_runs(arr.data(), 0, static_cast<std::ptrdiff_t>(arr.size()), std::less<int>());
         if (!merged) {
             std::cout << "Random array correctly rejected." << std::endl;
         } else {
@@ -103,7 +105,7 @@ void test_try_merge_runs() {
         // Run 3: 4000..5999
         for(int i=0; i<run_len; ++i) arr.push_back(4000 + i);
 
-        bool merged = try_merge_runs(arr.data(), 0, arr.size());
+        bool merged = try_merge_runs(arr.data(), 0, static_cast<std::ptrdiff_t>(arr.size()), std::less<int>());
 
         if (merged) {
             std::cout << "Large runs detected and merged." << std::endl;
@@ -117,8 +119,112 @@ void test_try_merge_runs() {
     std::cout << "Passed." << std::endl;
 }
 
+// Every run of 'run' is ascending and the runs cover [low, high)
+template<typename T>
+void check_runs(const std::vector<T>& arr, const std::pmr::vector<std::ptrdiff_t>& run, std::ptrdiff_t low, std::ptrdiff_t high) {
+    if (run.empty()) {
+        assert(std::is_sorted(arr.begin() + low, arr.begin() + high));
+        return;
+    }
+    assert(run.front() == low && run.back() == high);
+    for (std::size_t i = 0; i + 1 < run.size(); ++i) {
+        assert(run[i] < run[i + 1]);
+        assert(std::is_sorted(arr.begin() + run[i], arr.begin() + run[i + 1]));
+    }
+}
+
+void test_parallel_scan() {
+    std::cout << "Testing scan_runs_parallel..." << std::endl;
+
+    getThreadPool(4);
+    std::mt19937 rng(7);
+    const std::ptrdiff_t n = std::ptrdiff_t(1) << 20;
+
+    // Ascending runs: the stitched runs are exactly the sequential ones
+    for (std::ptrdiff_t run_length : {std::ptrdiff_t(1000), std::ptrdiff_t(65536), std::ptrdiff_t(100003), n}) {
+        std::vector<int> arr(n);
+        for (std::ptrdiff_t i = 0; i < n; ++i) arr[i] = static_cast<int>(i % run_length);
+        std::vector<int> copy = arr;
+        std::pmr::vector<std::ptrdiff_t> sequential, parallel;
+        assert(scan_runs(copy.data(), 0, n, std::less<int>(), sequential, dual_pivot::MIN_FIRST_RUN_SIZE, dual_pivot::MAX_RUN_CAPACITY));
+        assert(scan_runs_parallel(arr.data(), 0, n, std::less<int>(), parallel));
+        check_runs(arr, parallel, 0, n);
+        if (sequential.empty()) {
+            assert(parallel.size() == 2);
+        } else {
+            assert(parallel == sequential);
+        }
+    }
+
+    // Descending runs crossing chunk boundaries, constant stretches, a subrange
+    std::vector<int> arr(n);
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        std::ptrdiff_t r = i / 300007;
+        arr[i] = (r % 2 == 0) ? static_cast<int>(i % 300007) : static_cast<int>(300007 - i % 300007);
+        if (i % 300007 > 1000 && i % 300007 < 3000) arr[i] = arr[i - 1];
+    }
+    std::pmr::vector<std::ptrdiff_t> run;
+    assert(scan_runs_parallel(arr.data(), 5, n - 5, std::less<int>(), run));
+    check_runs(arr, run, 5, n - 5);
+
+    // Random data fails on its first elements; short runs fail in their chunk
+    std::vector<int> random(n);
+    for (auto& x : random) x = static_cast<int>(rng());
+    run.clear();
+    assert(!scan_runs_parallel(random.data(), 0, n, std::less<int>(), run));
+    std::vector<int> late = random;
+    std::sort(late.begin(), late.begin() + n / 2);
+    run.clear();
+    assert(!scan_runs_parallel(late.data(), 0, n, std::less<int>(), run));
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T, typename Compare>
+void check_parallel_merge(std::vector<T> arr, Compare comp, bool expect_merged) {
+    std::vector<T> expected = arr;
+    std::sort(expected.begin(), expected.end(), comp);
+    bool merged = parallel_try_merge_runs(arr.data(), 0, static_cast<std::ptrdiff_t>(arr.size()), comp, 4);
+    assert(merged == expect_merged);
+    if (merged) assert(arr == expected);
+}
+
+void test_parallel_merge() {
+    std::cout << "Testing parallel try_merge_runs..." << std::endl;
+
+    std::mt19937 rng(3);
+    const std::size_t n = std::size_t(1) << 21;
+    std::vector<int> sorted(n), reversed(n), sawtooth(n), runs(n), random(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        sorted[i] = static_cast<int>(i / 3);
+        reversed[i] = static_cast<int>(n - i);
+        sawtooth[i] = static_cast<int>(i % 5000);
+        random[i] = static_cast<int>(rng());
+    }
+    runs = random;
+    for (std::size_t r = 0; r < 37; ++r) {
+        auto first = runs.begin() + n * r / 37, last = runs.begin() + n * (r + 1) / 37;
+        std::sort(first, last);
+        if (r % 3 == 1) std::reverse(first, last);
+    }
+    check_parallel_merge(sorted, std::less<int>(), true);
+    check_parallel_merge(reversed, std::less<int>(), true);
+    check_parallel_merge(sawtooth, std::less<int>(), true);
+    check_parallel_merge(runs, std::less<int>(), true);
+    check_parallel_merge(runs, std::greater<int>(), true);
+    check_parallel_merge(random, std::less<int>(), false);
+
+    std::vector<std::string> strings(300000);
+    for (std::size_t i = 0; i < strings.size(); ++i) strings[i] = std::to_string(100000 + (i * 7919) % 150000);
+    std::sort(strings.begin(), strings.begin() + 150000);
+    std::sort(strings.begin() + 150000, strings.end());
+    check_parallel_merge(strings, std::less<std::string>(), true);
+    std::cout << "Passed." << std::endl;
+}
+
 int main() {
     test_try_merge_runs();
+    test_parallel_scan();
+    test_parallel_merge();
 
     std::cout << "All run merger tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+void test_splitter_tree() {
+    std::cout << "Testing SplitterTree classification..." << std::endl;
+
+    std::vector<int> splitters;
+    for (int i = 1; i <= 100; ++i) splitters.push_back(i * 10);
+    SplitterTree<int, std::less<int>> tree(splitters, std::less<int>());
+    assert(!tree.has_equal_buckets());
+    assert(tree.bucket_count() == 128);
+    for (int x = -5; x < 1100; ++x) {
+        // Bucket = number of splitters less than x; above all of them is the last bucket
+        std::size_t expected = std::lower_bound(splitters.begin(), splitters.end(), x) - splitters.begin();
+        if (expected == splitters.size()) expected = tree.bucket_count() - 1;
+        assert(tree.classify(x) == expected);
+    }
+
+    // Duplicates switch on equality buckets
+    std::vector<int> repeated = {5, 5, 5, 7, 9, 9};
+    SplitterTree<int, std::less<int>> equal_tree(repeated, std::less<int>());
+    assert(equal_tree.has_equal_buckets());
+    assert(equal_tree.classify(4) == 0);
+    assert(equal_tree.classify(5) == 1 && equal_tree.is_equal_bucket(1));
+    assert(equal_tree.classify(6) == 2);
+    assert(equal_tree.classify(7) == 3);
+    assert(equal_tree.classify(9) == 5);
+    std::size_t above = equal_tree.classify(10);
+    assert(!equal_tree.is_equal_bucket(above) && above > 5);
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T, typename Compare = std::less<T>>
+void check_distribution(std::vector<T> data, int threads, Compare comp = Compare()) {
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), comp);
+
+    auto& pool = getThreadPool(4);
+    std::ptrdiff_t n = static_cast<std::ptrdiff_t>(data.size());
+    SplitterTree<T, Compare> tree = select_splitters(data.data(), 0, n, comp);
+    std::vector<std::ptrdiff_t> bounds = SampleSortPartitioner<T, Compare>(data.data(), 0, n, tree, pool, threads).partition();
+
+    assert(bounds.size() == tree.bucket_count() + 1);
+    assert(bounds.front() == 0 && bounds.back() == n);
+    for (std::size_t b = 0; b + 1 < bounds.size(); ++b) {
+        assert(bounds[b] <= bounds[b + 1]);
+        for (std::ptrdiff_t i = bounds[b]; i < bounds[b + 1]; ++i) {
+            assert(tree.classify(data[i]) == b);
+        }
+    }
+
+    // Same elements after sorting the buckets
+    for (std::size_t b = 0; b + 1 < bounds.size(); ++b) {
+        std::sort(data.begin() + bounds[b], data.begin() + bounds[b + 1], comp);
+    }
+    assert(data == expected);
+}
+
+void test_partitioner() {
+    std::cout << "Testing SampleSortPartitioner..." << std::endl;
+
+    std::mt19937 rng(42);
+    const std::ptrdiff_t block = SampleSortPartitioner<int, std::less<int>>::BLOCK;
+    // Less than one block, exact blocks, and tails that use the overflow block
+    for (std::ptrdiff_t n : {std::ptrdiff_t(2), std::ptrdiff_t(300), block * 64, block * 700 + 17, std::ptrdiff_t(400001)}) {
+        for (int threads : {1, 2, 3, 5}) {
+            std::vector<int> random(n), dups(n), equal(n, 7);
+            for (auto& x : random) x = static_cast<int>(rng());
+            for (auto& x : dups) x = static_cast<int>(rng() % 5);
+            check_distribution(random, threads);
+            check_distribution(dups, threads);
+            check_distribution(equal, threads);
+        }
+    }
+
+    std::vector<std::string> strings(20000);
+    for (auto& s : strings) s = std::to_string(rng() % 3000);
+    check_distribution(strings, 3);
+
+    std::vector<double> reversed(100000);
+    for (std::size_t i = 0; i < reversed.size(); ++i) reversed[i] = static_cast<double>(i);
+    check_distribution(reversed, 4, std::greater<double>());
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T, typename Compare = std::less<T>>
+void check_sort(std::vector<T> data, int parallelism, Compare comp = Compare()) {
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), comp);
+    parallelSampleSort(data.data(), 0, 0, static_cast<std::ptrdiff_t>(data.size()), comp, parallelism);
+    assert(data == expected);
+}
+
+void test_parallel_samplesort() {
+    std::cout << "Testing parallelSampleSort..." << std::endl;
+
+    std::mt19937 rng(7);
+    const std::size_t n = 1000000;
+    for (int parallelism : {1, 2, 4}) {
+        std::vector<int> random(n), dups(n), sorted(n), reversed(n);
+        for (auto& x : random) x = static_cast<int>(rng());
+        for (auto& x : dups) x = static_cast<int>(rng() % 100);
+        for (std::size_t i = 0; i < n; ++i) {
+            sorted[i] = static_cast<int>(i);
+            reversed[i] = static_cast<int>(n - i);
+        }
+        check_sort(random, parallelism);
+        check_sort(dups, parallelism);
+        check_sort(sorted, parallelism);
+        check_sort(reversed, parallelism);
+        check_sort(std::vector<int>(n, 3), parallelism);
+        check_sort(random, parallelism, std::greater<int>());
+    }
+
+    std::vector<double> doubles(300000);
+    for (auto& x : doubles) x = std::uniform_real_distribution<double>(-1.0, 1.0)(rng);
+    check_sort(doubles, 3);
+
+    std::vector<std::string> strings(100000);
+    for (auto& s : strings) s = "key" + std::to_string(rng() % 50000);
+    check_sort(strings, 3);
+
+    // Subrange: the elements around it stay put
+    std::vector<long> ranged(200000);
+    for (auto& x : ranged) x = static_cast<long>(rng());
+    std::vector<long> expected = ranged;
+    std::sort(expected.begin() + 1000, expected.end() - 1000);
+    parallelSampleSort(ranged.data(), 0, 1000, static_cast<std::ptrdiff_t>(ranged.size()) - 1000, std::less<long>(), 2);
+    assert(ranged == expected);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sort_dispatch() {
+    std::cout << "Testing sort() above SAMPLESORT_THRESHOLD..." << std::endl;
+
+    std::mt19937 rng(3);
+    std::vector<int> data(static_cast<std::size_t>(SAMPLESORT_THRESHOLD) + 123);
+    for (auto& x : data) x = static_cast<int>(rng());
+    std::vector<int> expected = data;
+    std::sort(expected.begin(), expected.end());
+    sort(data, 4);
+    assert(data == expected);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_splitter_tree();
+    test_partitioner();
+    test_parallel_samplesort();
+    test_sort_dispatch();
+
+    std::cout << "All samplesort tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+// Heap allocations made by this thread while counting is on
+thread_local bool counting = false;
+thread_local std::size_t heap_allocations = 0;
+
+void* operator new(std::size_t size) {
+    if (counting) ++heap_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (counting) ++heap_allocations;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) return p;
+    throw std::bad_alloc();
+}
+
+// The replacement new gets its memory from malloc, so free is the matching
+// release; GCC cannot tell once these are inlined into a delete expression
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+// Counts what goes through it; thread-safe like the default resource
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::atomic<std::size_t> allocations{0};
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+void test_scratch_arena() {
+    std::cout << "Testing ScratchArena..." << std::endl;
+
+    alignas(64) std::byte memory[1024];
+    ScratchArena arena(memory, sizeof(memory));
+    void* a = arena.allocate(10, 1);
+    void* b = arena.allocate(100, 64);
+    assert(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+    assert(arena.used() == 164);
+
+    // Freeing the last block gives it back; freeing out of order does not
+    arena.deallocate(a, 10, 1);
+    assert(arena.used() == 164);
+    arena.deallocate(b, 100, 64);
+    assert(arena.used() == 64);
+    void* c = arena.allocate(100, 64);
+    assert(c == b);
+    arena.deallocate(c, 100, 64);
+
+    bool thrown = false;
+    try {
+        (void)arena.allocate(2000, 8);
+    } catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(arena.peak() == 164);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_resource_scope() {
+    std::cout << "Testing ScratchResourceScope..." << std::endl;
+
+    assert(scratch_resource() == &BufferManager::instance());
+    CountingResource outer, inner;
+    {
+        ScratchResourceScope first(&outer);
+        assert(scratch_resource() == &outer);
+        {
+            ScratchResourceScope second(&inner);
+            assert(scratch_resource() == &inner);
+        }
+        assert(scratch_resource() == &outer);
+    }
+    assert(scratch_resource() == &BufferManager::instance());
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename T, typename Compare = std::less<T>>
+void check_no_heap(std::vector<T> data, Compare comp = Compare()) {
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), comp);
+    std::ptrdiff_t n = static_cast<std::ptrdiff_t>(data.size());
+    std::vector<std::byte> scratch(sort_scratch_size<T>(n));
+
+    counting = true;
+    heap_allocations = 0;
+    if constexpr (std::is_same_v<Compare, std::less<T>>) {
+        sort_with_scratch(data.data(), 0, n, scratch);
+    } else {
+        sort_with_scratch(data.data(), 0, n, comp, scratch);
+    }
+    counting = false;
+    assert(heap_allocations == 0);
+    assert(data == expected);
+}
+
+void test_sort_with_scratch() {
+    std::cout << "Testing sort_with_scratch (no heap allocation)..." << std::endl;
+
+    std::mt19937_64 rng(21);
+    for (std::size_t n : {std::size_t(0), std::size_t(5), std::size_t(300), std::size_t(5000), std::size_t(100000), std::size_t(1) << 20}) {
+        std::vector<int> random(n), runs(n), few(n);
+        std::vector<long> longs(n);
+        std::vector<double> doubles(n);
+        for (auto& x : random) x = static_cast<int>(rng());
+        for (auto& x : few) x = static_cast<int>(rng() % 4);
+        for (auto& x : longs) x = static_cast<long>(rng());
+        for (auto& x : doubles) x = std::uniform_real_distribution<double>(-1.0, 1.0)(rng);
+        runs = random;
+        for (int r = 0; r < 6; ++r) {
+            std::sort(runs.begin() + n * r / 6, runs.begin() + n * (r + 1) / 6);
+        }
+
+        check_no_heap(random);                           // radix sort
+        check_no_heap(runs);                             // run merger
+        check_no_heap(few);
+        check_no_heap(longs);
+        check_no_heap(doubles);                          // sort_floats
+        check_no_heap(random, std::greater<int>());      // dual-pivot quicksort
+        check_no_heap(runs, std::greater<int>());
+    }
+
+    // Counting tables are per thread: only the first counting sort allocates them
+    std::vector<unsigned short> shorts(200000);
+    for (auto& x : shorts) x = static_cast<unsigned short>(rng());
+    std::vector<unsigned short> warm_up = shorts;
+    sort(warm_up, 1);
+    check_no_heap(shorts);
+
+    // Too little scratch memory fails cleanly
+    std::vector<int> runs(100000);
+    for (auto& x : runs) x = static_cast<int>(rng());
+    std::sort(runs.begin(), runs.begin() + 50000);
+    std::sort(runs.begin() + 50000, runs.end());
+    std::vector<std::byte> small(1024);
+    bool thrown = false;
+    try {
+        sort_with_scratch(runs.data(), 0, static_cast<std::ptrdiff_t>(runs.size()), small);
+    } catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sort_with_resource() {
+    std::cout << "Testing sort_with_resource..." << std::endl;
+
+    std::mt19937_64 rng(8);
+    std::vector<int> runs(1 << 20);
+    for (auto& x : runs) x = static_cast<int>(rng());
+    std::sort(runs.begin(), runs.begin() + (1 << 19));
+    std::sort(runs.begin() + (1 << 19), runs.end(), std::greater<int>());
+    std::vector<int> expected = runs;
+    std::sort(expected.begin(), expected.end());
+
+    CountingResource resource;
+    std::vector<int> sequential = runs;
+    sort_with_resource(sequential, 1, &resource);
+    assert(sequential == expected);
+    assert(resource.allocations > 0);
+
+    // The radix buffer of a parallel sort comes from the resource too
+    std::vector<long> random(1 << 20);
+    for (auto& x : random) x = static_cast<long>(rng());
+    std::vector<long> expected_random = random;
+    std::sort(expected_random.begin(), expected_random.end());
+    std::size_t before = resource.allocations;
+    sort_with_resource(random.data(), 4, 0, static_cast<std::ptrdiff_t>(random.size()), &resource);
+    assert(random == expected_random);
+    assert(resource.allocations > before);
+
+    // The copy of a non-contiguous range for a parallel sort as well
+    std::deque<int> deque(runs.begin(), runs.end());
+    before = resource.allocations;
+    {
+        ScratchResourceScope scope(&resource);
+        dual_pivot_quicksort_parallel(deque.begin(), deque.end(), std::less<int>(), 2);
+    }
+    assert(std::equal(deque.begin(), deque.end(), expected.begin()));
+    assert(resource.allocations > before);
+    assert(scratch_resource() == &BufferManager::instance());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_iterator_comparator() {
+    std::cout << "Testing non-contiguous ranges with a comparator (no copy)..." << std::endl;
+
+    std::mt19937 rng(4);
+    std::deque<int> deque(50000);
+    for (auto& x : deque) x = static_cast<int>(rng() % 1000);
+    std::vector<int> expected(deque.begin(), deque.end());
+    std::sort(expected.begin(), expected.end(), std::greater<int>());
+
+    counting = true;
+    heap_allocations = 0;
+    dual_pivot_quicksort(deque.begin(), deque.end(), std::greater<int>());
+    counting = false;
+    assert(heap_allocations == 0);
+    assert(std::equal(deque.begin(), deque.end(), expected.begin()));
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_scratch_arena();
+    test_resource_scope();
+    test_sort_with_scratch();
+    test_sort_with_resource();
+    test_iterator_comparator();
+
+    std::cout << "All scratch memory tests passed!" << std::endl;
+    return 0;
+}
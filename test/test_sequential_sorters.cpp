@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <random>
 #include <cassert>
+#include <cmath>
+#include <numeric>
 #include "dpqs/sequential_sorters.hpp"
 
 using namespace dual_pivot;
@@ -45,9 +47,195 @@ void test_sort_double() {
     std::cout << "Passed." << std::endl;
 }
 
+void test_partial_insertion_sort() {
+    std::cout << "Testing partial_insertion_sort..." << std::endl;
+
+    // Sorted input and a few local inversions are finished by the probe
+    std::vector<int> arr(500);
+    std::iota(arr.begin(), arr.end(), 0);
+    assert(partial_insertion_sort(arr.data(), 0, (std::ptrdiff_t)arr.size(), std::less<int>()));
+    assert(is_sorted(arr));
+
+    std::swap(arr[10], arr[11]);
+    std::swap(arr[300], arr[302]);
+    assert(partial_insertion_sort(arr.data(), 0, (std::ptrdiff_t)arr.size(), std::less<int>()));
+    assert(is_sorted(arr));
+
+    // Reverse sorted input makes it give up, leaving a permutation behind
+    std::reverse(arr.begin(), arr.end());
+    assert(!partial_insertion_sort(arr.data(), 0, (std::ptrdiff_t)arr.size(), std::less<int>()));
+    std::vector<int> copy = arr;
+    std::sort(copy.begin(), copy.end());
+    for (size_t i = 0; i < copy.size(); ++i) assert(copy[i] == (int)i);
+
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sort_patterns() {
+    std::cout << "Testing sort_sequential on patterned inputs..." << std::endl;
+
+    std::mt19937 g(7);
+    for (int n : {50, 300, 1000, 5000, 70000}) {
+        for (int p = 0; p < 9; ++p) {
+            std::vector<int> arr(n);
+            for (int i = 0; i < n; ++i) {
+                switch (p) {
+                    case 0: arr[i] = i; break;                           // sorted
+                    case 1: arr[i] = n - i; break;                       // reverse
+                    case 2: arr[i] = i < n / 2 ? i : n - i; break;       // organ pipe
+                    case 3: arr[i] = i % 17; break;                      // sawtooth
+                    case 4: arr[i] = 42; break;                          // all equal
+                    case 5: arr[i] = i % 3 == 0 ? i : -i; break;         // interleaved
+                    case 6: arr[i] = (i % 64 == 0) ? (int)g() : i; break; // sorted + noise
+                    case 7: arr[i] = (int)((i * 7919LL) % n); break;     // strided permutation
+                    case 8: arr[i] = (int)(g() % 4); break;              // few distinct
+                }
+            }
+            std::vector<int> expected = arr;
+            std::sort(expected.begin(), expected.end());
+
+            sort_sequential<int, std::less<int>>(nullptr, arr.data(), 0, 0, n, std::less<int>());
+            assert(arr == expected);
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+// Adversary after McIlroy ("A Killer Adversary for Quicksort"): values are decided
+// lazily while the sort runs, always making freshly compared elements the smallest.
+struct KillerAdversary {
+    std::vector<int>* val;
+    int* solid;
+    int gas;
+
+    bool operator()(int x, int y) const {
+        std::vector<int>& v = *val;
+        if (v[x] == gas) v[x] = (*solid)++;
+        if (v[y] == gas) v[y] = (*solid)++;
+        return v[x] < v[y];
+    }
+};
+
+void test_sort_adversary() {
+    std::cout << "Testing sort_sequential against a quicksort adversary..." << std::endl;
+
+    const int n = 100000;
+    std::vector<int> val(n, n);
+    std::vector<int> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+    int solid = 0;
+    sort_sequential<int, KillerAdversary>(nullptr, idx.data(), 0, 0, n, KillerAdversary{&val, &solid, n});
+
+    // Replay the input the adversary constructed. Without the pattern-defeating
+    // safeguards it costs over 5 n log2(n) comparisons (64 levels of 5-element
+    // progress before the heap sort fallback).
+    long comparisons = 0;
+    auto counting = [&comparisons](int x, int y) { ++comparisons; return x < y; };
+    sort_sequential<int, decltype(counting)>(nullptr, val.data(), 0, 0, n, counting);
+
+    for (int i = 0; i < n; ++i) assert(val[i] == i);
+    assert(comparisons < 3.0 * n * std::log2(n));
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sampler_adversary() {
+    std::cout << "Testing pattern breaking against the adaptive sample..." << std::endl;
+
+    // The largest values sit at every position the adaptive sample reads
+    const std::ptrdiff_t n = 200000;
+    static_assert(n >= ADAPTIVE_SAMPLE_MIN_SIZE);
+    std::vector<int> killer(n);
+    std::iota(killer.begin(), killer.end(), 0);
+    std::shuffle(killer.begin(), killer.end(), std::mt19937(17));
+    std::ptrdiff_t positions[MAX_ADAPTIVE_SAMPLE_SIZE];
+    std::ptrdiff_t count = AdaptivePivotSampler::positions(0, n, positions);
+    for (std::ptrdiff_t i = 0; i < count; ++i) {
+        std::swap(killer[positions[i]], *std::find(killer.begin(), killer.end(), static_cast<int>(n - 1 - i)));
+    }
+
+    std::vector<int> arr = killer;
+    PivotSample sample = DefaultPivotSampler::select(arr.data(), 0, n, std::less<int>());
+    assert(arr[sample.pivot1] >= n - count);
+
+    // Breaking the pattern scatters the whole sample, so the pivots fall inside the range again
+    arr = killer;
+    DefaultPivotSampler::break_patterns(arr.data(), 0, n);
+    sample = DefaultPivotSampler::select(arr.data(), 0, n, std::less<int>());
+    assert(arr[sample.pivot1] > n / 10 && arr[sample.pivot2] < n - n / 10);
+    assert(arr[sample.pivot1] < arr[sample.pivot2]);
+
+    // A full sort with the default sampler stays O(n log n)
+    arr = killer;
+    long comparisons = 0;
+    auto counting = [&comparisons](int x, int y) { ++comparisons; return x < y; };
+    sort_sequential<int, decltype(counting)>(nullptr, arr.data(), 0, 0, n, counting);
+    for (std::ptrdiff_t i = 0; i < n; ++i) assert(arr[i] == i);
+    assert(comparisons < 3.0 * n * std::log2(n));
+    std::cout << "Passed." << std::endl;
+}
+
+template<typename PivotSampler>
+void check_sampler_sorts(const char* name) {
+    std::mt19937 g(11);
+    for (int n : {100, 4095, 4096, 20000, 300000}) {
+        for (int p = 0; p < 3; ++p) {
+            std::vector<int> arr(n);
+            for (int i = 0; i < n; ++i) {
+                arr[i] = p == 0 ? (int)g() : p == 1 ? (int)(g() % 5) : i;
+            }
+            std::vector<int> expected = arr;
+            std::sort(expected.begin(), expected.end());
+
+            sort_sequential<int, std::less<int>, PivotSampler>(nullptr, arr.data(), 0, 0, n, std::less<int>());
+            if (arr != expected) {
+                std::cerr << name << " failed for n=" << n << " pattern=" << p << std::endl;
+                assert(false);
+            }
+        }
+    }
+}
+
+void test_pivot_samplers() {
+    std::cout << "Testing pivot sampling policies..." << std::endl;
+
+    // Adaptive samples have the form 3t + 2, grow with the range and stay bounded
+    std::ptrdiff_t previous = 0;
+    for (std::ptrdiff_t size = ADAPTIVE_SAMPLE_MIN_SIZE; size < (std::ptrdiff_t(1) << 30); size *= 2) {
+        std::ptrdiff_t count = adaptive_sample_size(size);
+        assert(count % 3 == 2);
+        assert(count >= 5 && count <= MAX_ADAPTIVE_SAMPLE_SIZE);
+        assert(count >= previous);
+        previous = count;
+    }
+
+    // Pivots are distinct, ordered and inside the range
+    std::vector<int> arr(50000);
+    std::mt19937 g(3);
+    for (auto& x : arr) x = (int)g();
+    PivotSample sample = AdaptivePivotSampler::select(arr.data(), 0, (std::ptrdiff_t)arr.size(), std::less<int>());
+    assert(sample.distinct && !sample.ordered);
+    assert(sample.pivot1 > 0 && sample.pivot2 < (std::ptrdiff_t)arr.size() - 1);
+    assert(arr[sample.pivot1] < arr[sample.median] && arr[sample.median] < arr[sample.pivot2]);
+
+    // All-equal input must fall back to single-pivot partitioning
+    std::vector<int> equal(50000, 7);
+    assert(!AdaptivePivotSampler::select(equal.data(), 0, (std::ptrdiff_t)equal.size(), std::less<int>()).distinct);
+    assert(!TertilePivotSampler::select(equal.data(), 0, (std::ptrdiff_t)equal.size(), std::less<int>()).distinct);
+
+    check_sampler_sorts<ExtremePivotSampler>("ExtremePivotSampler");
+    check_sampler_sorts<TertilePivotSampler>("TertilePivotSampler");
+    check_sampler_sorts<AdaptivePivotSampler>("AdaptivePivotSampler");
+    std::cout << "Passed." << std::endl;
+}
+
 int main() {
     test_sort_int();
     test_sort_double();
+    test_partial_insertion_sort();
+    test_sort_patterns();
+    test_sort_adversary();
+    test_sampler_adversary();
+    test_pivot_samplers();
 
     std::cout << "All sequential sorter tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+// A key and the position it started at; only the key is compared
+struct Record {
+    int key = 0;
+    int index = 0;
+    bool operator==(const Record& other) const { return key == other.key && index == other.index; }
+};
+
+struct ByKey {
+    bool operator()(const Record& x, const Record& y) const { return x.key < y.key; }
+};
+
+std::vector<Record> records(const std::vector<int>& keys) {
+    std::vector<Record> result(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) result[i] = {keys[i], static_cast<int>(i)};
+    return result;
+}
+
+template<typename T, typename Compare>
+void check_stable(std::vector<T> data, int parallelism, Compare comp) {
+    std::vector<T> expected = data;
+    std::stable_sort(expected.begin(), expected.end(), comp);
+    stable_sort(data, parallelism, comp);
+    assert(data == expected);
+}
+
+std::vector<std::vector<int>> patterns(std::size_t n, std::mt19937& rng) {
+    std::vector<int> random(n), few(n), sorted(n), reversed(n), sawtooth(n), organ(n), nearly(n), runs(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        random[i] = static_cast<int>(rng() % 1000000);
+        few[i] = static_cast<int>(rng() % 5);
+        sorted[i] = static_cast<int>(i / 4);
+        reversed[i] = static_cast<int>((n - i) / 4);
+        sawtooth[i] = static_cast<int>(i % 97);
+        organ[i] = static_cast<int>(i < n / 2 ? i : n - i);
+        nearly[i] = static_cast<int>(i);
+    }
+    for (std::size_t i = 0; i < n / 100; ++i) std::swap(nearly[rng() % n], nearly[rng() % n]);
+    runs = random;
+    for (std::size_t r = 0; r < 9; ++r) {
+        auto first = runs.begin() + n * r / 9, last = runs.begin() + n * (r + 1) / 9;
+        std::sort(first, last);
+        if (r % 2 == 1) std::reverse(first, last);
+    }
+    return {random, few, sorted, reversed, sawtooth, organ, nearly, runs};
+}
+
+void test_records() {
+    std::cout << "Testing stable_sort keeps equal keys in order..." << std::endl;
+
+    std::mt19937 rng(22);
+    for (std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(31), std::size_t(33), std::size_t(1000),
+                          std::size_t(70000), std::size_t(600000)}) {
+        for (const auto& keys : patterns(n, rng)) {
+            for (int parallelism : {1, 2, 4}) {
+                check_stable(records(keys), parallelism, ByKey());
+                check_stable(records(keys), parallelism, [](const Record& x, const Record& y) { return x.key / 8 > y.key / 8; });
+            }
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_other_types() {
+    std::cout << "Testing stable_sort on strings and floating point..." << std::endl;
+
+    std::mt19937 rng(5);
+    std::vector<std::string> strings(200000);
+    for (auto& s : strings) s = std::to_string(rng() % 50000);
+    for (int parallelism : {1, 4}) {
+        check_stable(strings, parallelism, std::less<std::string>());
+        // Only the length is compared
+        check_stable(strings, parallelism, [](const std::string& x, const std::string& y) { return x.size() < y.size(); });
+    }
+
+    // -0.0 and +0.0 are equal in std::less order and keep their order
+    std::vector<double> zeros(300000);
+    for (auto& x : zeros) x = (rng() % 3 == 0) ? static_cast<double>(rng() % 10) : ((rng() & 1) ? 0.0 : -0.0);
+    for (int parallelism : {1, 4}) {
+        std::vector<double> sorted = zeros;
+        std::vector<double> expected = zeros;
+        std::stable_sort(expected.begin(), expected.end());
+        stable_sort(sorted, parallelism);
+        for (std::size_t i = 0; i < sorted.size(); ++i) {
+            assert(sorted[i] == expected[i] && std::signbit(sorted[i]) == std::signbit(expected[i]));
+        }
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_api() {
+    std::cout << "Testing stable_sort overloads..." << std::endl;
+
+    std::mt19937 rng(9);
+    std::vector<long> longs(100000);
+    for (auto& x : longs) x = static_cast<long>(rng() % 1000);
+    std::vector<long> expected = longs;
+    std::sort(expected.begin(), expected.end());
+
+    // Integers in std::less order take sort()
+    std::vector<long> copy = longs;
+    stable_sort(copy);
+    assert(copy == expected);
+    copy = longs;
+    stable_sort(copy, 4);
+    assert(copy == expected);
+
+    // A subrange, the elements outside it stay put
+    std::vector<Record> data = records(std::vector<int>(longs.begin(), longs.end()));
+    std::vector<Record> ranged = data;
+    std::stable_sort(ranged.begin() + 100, ranged.end() - 100, ByKey());
+    stable_sort(data.data(), 4, 100, static_cast<std::ptrdiff_t>(data.size()) - 100, ByKey());
+    assert(data == ranged);
+
+    bool thrown = false;
+    try {
+        stable_sort(data.data(), 1, -1, 10, ByKey());
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_records();
+    test_other_types();
+    test_api();
+
+    std::cout << "All stable sort tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stop_token>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "dual_pivot_quicksort.hpp"
+
+using namespace dual_pivot;
+
+using Clock = std::chrono::steady_clock;
+
+// Requests a stop on its 'limit'-th call, counted over all threads
+template<typename T>
+struct StoppingLess {
+    std::stop_source* source;
+    std::atomic<long>* calls;
+    long limit;
+    bool operator()(const T& x, const T& y) const {
+        if (calls->fetch_add(1, std::memory_order_relaxed) + 1 == limit) {
+            source->request_stop();
+        }
+        return x < y;
+    }
+};
+
+template<typename T>
+bool same_elements(std::vector<T> x, std::vector<T> y) {
+    std::sort(x.begin(), x.end());
+    std::sort(y.begin(), y.end());
+    return x == y;
+}
+
+std::vector<double> random_doubles(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<double> data(n);
+    for (auto& x : data) x = static_cast<double>(rng() % 1000000) / 3;
+    return data;
+}
+
+void test_condition() {
+    std::cout << "Testing SortStop..." << std::endl;
+
+    std::stop_source source;
+    SortStop by_token(source.get_token());
+    assert(!by_token.requested() && !by_token.stopped());
+    source.request_stop();
+    assert(by_token.requested() && by_token.stopped());
+
+    SortStop by_deadline(std::stop_token(), Clock::now() - std::chrono::milliseconds(1));
+    assert(by_deadline.requested());
+    SortStop never(std::stop_token(), Clock::now() + std::chrono::hours(1));
+    assert(!never.requested() && !never.stopped());
+
+    // Scopes nest and restore the previous condition
+    assert(!sort_stop_requested());
+    {
+        SortStopScope outer(&never);
+        assert(!sort_stop_requested());
+        {
+            SortStopScope inner(&by_token);
+            assert(sort_stop_requested());
+        }
+        assert(sort_stop_requested() == false);
+    }
+    assert(sort_stop_slot() == nullptr);
+    std::cout << "Passed." << std::endl;
+}
+
+// Runs 'sort_call' with a comparator stopping the sort on comparison 'limit'
+template<typename T, typename SortCall>
+void check_stopped(const std::vector<T>& input, long limit, SortCall sort_call) {
+    std::vector<T> data = input;
+    std::stop_source source;
+    std::atomic<long> calls{0};
+    bool sorted = sort_call(data, StoppingLess<T>{&source, &calls, limit}, source.get_token());
+    assert(same_elements(data, input));
+    if (sorted) {
+        assert(std::is_sorted(data.begin(), data.end()));
+    } else {
+        assert(source.stop_requested());
+    }
+}
+
+void test_stop_token() {
+    std::cout << "Testing sorts stopped by a token keep a permutation..." << std::endl;
+
+    const std::size_t n = 400000;
+    std::vector<std::vector<double>> inputs;
+    inputs.push_back(random_doubles(n, 1));
+    std::vector<double> sawtooth(n), descending(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        sawtooth[i] = static_cast<double>(i % 20000);
+        descending[i] = static_cast<double>(n - i);
+    }
+    inputs.push_back(sawtooth);
+    inputs.push_back(descending);
+
+    // Early, middle and late stops: in the run scan, the partitioning and the merges
+    for (const auto& input : inputs) {
+        for (long limit : {1L, 1000L, 300000L, 2000000L, 5000000L}) {
+            using Less = StoppingLess<double>;
+            for (int parallelism : {1, 4}) {
+                check_stopped(input, limit, [parallelism](std::vector<double>& v, Less comp, std::stop_token stop) {
+                    return sort(v, parallelism, comp, stop);
+                });
+            }
+            check_stopped(input, limit, [](std::vector<double>& v, Less comp, std::stop_token stop) {
+                SortStop condition(stop);
+                SortStopScope scope(&condition);
+                parallelSampleSort(v.data(), 0, 0, static_cast<std::ptrdiff_t>(v.size()), comp, 4);
+                return !condition.stopped();
+            });
+            check_stopped(input, limit, [](std::vector<double>& v, Less comp, std::stop_token stop) {
+                SortStop condition(stop);
+                SortStopScope scope(&condition);
+                parallelMergeSort(v.data(), -2, 0, static_cast<std::ptrdiff_t>(v.size()), comp, 4);
+                return !condition.stopped();
+            });
+        }
+    }
+
+    // Strings: a stopped merge moves its runs, it does not leave moved-from elements behind
+    std::mt19937 rng(3);
+    std::vector<std::string> strings(200000);
+    for (auto& s : strings) s = std::to_string(rng() % 100000);
+    for (long limit : {1000L, 500000L, 2000000L}) {
+        using Less = StoppingLess<std::string>;
+        check_stopped(strings, limit, [](std::vector<std::string>& v, Less comp, std::stop_token stop) {
+            return sort(v, 4, comp, stop);
+        });
+        check_stopped(strings, limit, [](std::vector<std::string>& v, Less comp, std::stop_token stop) {
+            SortStop condition(stop);
+            SortStopScope scope(&condition);
+            parallelMergeSort(v.data(), -2, 0, static_cast<std::ptrdiff_t>(v.size()), comp, 4);
+            return !condition.stopped();
+        });
+        check_stopped(strings, limit, [](std::vector<std::string>& v, Less comp, std::stop_token stop) {
+            SortStop condition(stop);
+            SortStopScope scope(&condition);
+            stable_sort(v.data(), 4, 0, static_cast<std::ptrdiff_t>(v.size()), comp);
+            return !condition.stopped();
+        });
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void test_api() {
+    std::cout << "Testing stoppable sort overloads and deadlines..." << std::endl;
+
+    const std::size_t n = 1000000;
+    std::vector<double> input = random_doubles(n, 7);
+    std::vector<double> expected = input;
+    std::sort(expected.begin(), expected.end());
+
+    // Not stopped: sorted, as by sort()
+    std::vector<double> data = input;
+    assert(sort(data, 4, std::stop_token()));
+    assert(data == expected);
+    data = input;
+    assert(sort(data.data(), 1, 0, static_cast<std::ptrdiff_t>(n), std::greater<double>(), std::stop_token(),
+                Clock::now() + std::chrono::hours(1)));
+    assert(std::is_sorted(data.begin(), data.end(), std::greater<double>()));
+
+    // Floating point in the order of sort(): -0.0 before 0.0, NaNs last
+    std::vector<double> zeros = {1.0, std::nan(""), 0.0, -0.0, -1.0, std::nan("")};
+    std::vector<double> sorted_zeros = zeros;
+    sort(sorted_zeros);
+    std::vector<double> stoppable_zeros = zeros;
+    assert(sort(stoppable_zeros, 1, std::stop_token()));
+    for (std::size_t i = 0; i < zeros.size(); ++i) {
+        assert(std::isnan(stoppable_zeros[i]) == std::isnan(sorted_zeros[i]));
+        if (!std::isnan(sorted_zeros[i])) {
+            assert(stoppable_zeros[i] == sorted_zeros[i] && std::signbit(stoppable_zeros[i]) == std::signbit(sorted_zeros[i]));
+        }
+    }
+
+    // Stopped before the start, or a deadline that has passed: nothing beyond the first pass
+    for (int parallelism : {1, 4}) {
+        std::stop_source source;
+        source.request_stop();
+        data = input;
+        assert(!sort(data, parallelism, source.get_token()));
+        assert(same_elements(data, input) && data != expected);
+
+        data = input;
+        assert(!sort(data, parallelism, std::stop_token(), Clock::now() - std::chrono::seconds(1)));
+        assert(same_elements(data, input) && data != expected);
+    }
+
+    // A stop from another thread during the sort
+    std::vector<long> longs(4000000);
+    std::mt19937 rng(11);
+    for (auto& x : longs) x = static_cast<long>(rng());
+    for (int parallelism : {1, 4}) {
+        std::vector<long> copy = longs;
+        std::stop_source source;
+        std::thread stopper([&source] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            source.request_stop();
+        });
+        bool sorted = sort(copy, parallelism, source.get_token());
+        stopper.join();
+        assert(same_elements(copy, longs));
+        assert(!sorted || std::is_sorted(copy.begin(), copy.end()));
+    }
+
+    // The stop does not outlive its call
+    assert(sort_stop_slot() == nullptr);
+    data = input;
+    sort(data, 4);
+    assert(data == expected);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_condition();
+    test_stop_token();
+    test_api();
+
+    std::cout << "All stop tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,367 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cassert>
+#include <chrono>
+#include "dpqs/parallel/threadpool.hpp"
+
+using namespace dual_pivot;
+
+void test_task_storage() {
+    std::cout << "Testing Task storage..." << std::endl;
+
+    // Closures like the ones parallel_sort_task submits are stored inline
+    int* a = nullptr;
+    long low = 1, high = 2;
+    int bits = 3;
+    auto sort_like = [=] { (void)a; (void)low; (void)high; (void)bits; };
+    static_assert(Task::is_inline_v<decltype(sort_like)>);
+
+    int value = 0;
+    Task inline_task([&value] { value += 1; });
+    Task copy = inline_task;
+    copy();
+    assert(value == 1);
+
+    // Non-trivially copyable callables fall back to a heap box
+    std::string text = "boxed";
+    auto boxed = [text, &value] { value += static_cast<int>(text.size()); };
+    static_assert(!Task::is_inline_v<decltype(boxed)>);
+    Task boxed_task(boxed);
+    boxed_task();
+    assert(value == 6);
+
+    assert(!Task());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_deque_sequential() {
+    std::cout << "Testing WorkStealingDeque (single thread)..." << std::endl;
+
+    WorkStealingDeque deque;
+    std::vector<int> order;
+    const int count = 1000; // Forces several ring growths
+    for (int i = 0; i < count; ++i) {
+        deque.push(Task([&order, i] { order.push_back(i); }));
+    }
+    assert(deque.size() == count);
+
+    // Thieves take the oldest task, the owner the newest one
+    Task task;
+    assert(deque.try_steal(task));
+    task();
+    assert(deque.try_pop(task));
+    task();
+    assert(order[0] == 0 && order[1] == count - 1);
+
+    while (deque.try_pop(task)) task();
+    assert(deque.empty());
+    assert(!deque.try_steal(task));
+    assert((int)order.size() == count);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_deque_concurrent() {
+    std::cout << "Testing WorkStealingDeque (owner vs thieves)..." << std::endl;
+
+    const int count = 200000;
+    const int thieves = 3;
+    WorkStealingDeque deque;
+    std::vector<std::atomic<int>> runs(count);
+    std::atomic<int> done{0};
+    std::atomic<bool> finished{false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thieves; ++t) {
+        threads.emplace_back([&] {
+            Task task;
+            while (!finished.load()) {
+                if (deque.try_steal(task)) {
+                    task();
+                    done++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Owner interleaves pushes and pops, like a fork phase
+    Task task;
+    for (int i = 0; i < count; ++i) {
+        deque.push(Task([&runs, i] { runs[i]++; }));
+        if (i % 3 == 0 && deque.try_pop(task)) {
+            task();
+            done++;
+        }
+    }
+    while (done.load() < count) {
+        if (deque.try_pop(task)) {
+            task();
+            done++;
+        }
+    }
+    finished = true;
+    for (auto& t : threads) t.join();
+
+    for (int i = 0; i < count; ++i) {
+        assert(runs[i].load() == 1);
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+void spawn(ThreadPool& pool, std::atomic<long>& counter, int depth) {
+    counter++;
+    if (depth == 0) return;
+    pool.submit([&pool, &counter, depth] { spawn(pool, counter, depth - 1); });
+    pool.submit([&pool, &counter, depth] { spawn(pool, counter, depth - 1); });
+}
+
+void test_pool_nested_submit() {
+    std::cout << "Testing ThreadPool nested submissions..." << std::endl;
+
+    for (size_t threads : {1, 2, 4}) {
+        ThreadPool pool(threads);
+        std::atomic<long> counter{0};
+        pool.submit([&pool, &counter] { spawn(pool, counter, 12); });
+        pool.wait_for_completion();
+        assert(counter.load() == (1L << 13) - 1);
+        assert(pool.get_tasks_executed() == (1L << 13) - 1);
+        assert(pool.get_tasks_pushed() == pool.get_tasks_executed());
+    }
+    std::cout << "Passed." << std::endl;
+}
+
+bool wait_until_parked(ThreadPool& pool, int threads) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.get_parked_threads() < threads) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void test_pool_parking() {
+    std::cout << "Testing ThreadPool worker parking..." << std::endl;
+
+    ThreadPool pool(3);
+    // Idle workers stop spinning and park
+    assert(wait_until_parked(pool, 3));
+    assert(pool.get_parks() >= 3);
+
+    // A submission wakes a parked worker, repeatedly
+    for (int round = 0; round < 20; ++round) {
+        std::atomic<long> counter{0};
+        pool.submit([&pool, &counter] { spawn(pool, counter, 6); });
+        pool.wait_for_completion();
+        assert(counter.load() == (1L << 7) - 1);
+    }
+
+    // And the pool goes back to sleep afterwards
+    assert(wait_until_parked(pool, 3));
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pool_task_groups() {
+    std::cout << "Testing ThreadPool task groups..." << std::endl;
+
+    ThreadPool pool(2);
+    TaskGroup slow, fast;
+    std::atomic<bool> release{false};
+    std::atomic<long> counter{0};
+
+    // The slow group keeps one worker busy until it is released
+    pool.submit(slow, [&release] {
+        while (!release.load()) std::this_thread::yield();
+    });
+
+    // Children inherit the fast group, so waiting on it ignores the slow task
+    pool.submit(fast, [&pool, &counter] { spawn(pool, counter, 8); });
+    pool.wait(fast);
+    assert(fast.done());
+    assert(counter.load() == (1L << 9) - 1);
+    assert(!slow.done());
+    assert(slow.pending_tasks() == 1);
+
+    release = true;
+    pool.wait(slow);
+    assert(slow.done());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pool_caller_helps() {
+    std::cout << "Testing ThreadPool caller participation..." << std::endl;
+
+    ThreadPool pool(1);
+    TaskGroup blocked, own;
+    std::atomic<bool> release{false};
+    std::atomic<bool> other_ran{false};
+    std::atomic<long> counter{0};
+
+    // The only worker gets stuck in another group (injected tasks run in FIFO order)
+    pool.submit(blocked, [&release] {
+        while (!release.load()) std::this_thread::yield();
+    });
+    pool.submit(blocked, [&other_ran] { other_ran = true; });
+
+    // So the waiting thread has to run its whole tree itself...
+    pool.submit(own, [&pool, &counter] { spawn(pool, counter, 8); });
+    pool.wait(own);
+    assert(counter.load() == (1L << 9) - 1);
+
+    // ...without picking up tasks of the other group
+    assert(!other_ran.load());
+    assert(blocked.pending_tasks() == 2);
+
+    release = true;
+    pool.wait(blocked);
+    assert(other_ran.load());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pool_budget() {
+    std::cout << "Testing ThreadPool concurrency budgets..." << std::endl;
+
+    ThreadPool pool(4);
+    for (int budget : {1, 2, 3}) {
+        TaskGroup group(budget);
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+        std::atomic<int> finished{0};
+        const int tasks = 64;
+
+        for (int t = 0; t < tasks; ++t) {
+            pool.submit(group, [&] {
+                int now = ++running;
+                int seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                --running;
+                ++finished;
+            });
+        }
+        pool.wait(group);
+        assert(finished.load() == tasks);
+        assert(peak.load() <= budget);
+        assert(group.active_threads() == 0);
+    }
+
+    // A group nested with inherit_budget counts against its parent's budget
+    TaskGroup outer(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    pool.submit(outer, [&] {
+        TaskGroup nested(TaskGroup::inherit_budget);
+        assert(nested.max_threads() == 2);
+        for (int t = 0; t < 32; ++t) {
+            pool.submit(nested, [&] {
+                int now = ++running;
+                int seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                --running;
+            });
+        }
+        pool.wait(nested);
+    });
+    pool.wait(outer);
+    assert(peak.load() <= 2);
+    assert(outer.active_threads() == 0);
+    assert(TaskGroup(TaskGroup::inherit_budget).max_threads() == 0);
+
+    // Unlimited groups still use every worker and the caller
+    assert(TaskGroup().max_threads() == 0);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pool_budget_idle_workers() {
+    std::cout << "Testing ThreadPool workers outside a budget..." << std::endl;
+
+    // A budget of 2 on 6 workers: the caller and one worker run the tree, the
+    // other workers park although the group's tasks stay queued
+    ThreadPool pool(6);
+    TaskGroup group(2);
+    std::atomic<long> counter{0};
+    std::atomic<bool> others_parked{false};
+    pool.submit(group, [&pool, &counter, &others_parked] {
+        for (int t = 0; t < 256; ++t) {
+            pool.submit([&counter] {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                counter++;
+            });
+        }
+        others_parked = wait_until_parked(pool, 5);
+    });
+    pool.wait(group);
+    assert(others_parked.load());
+    assert(counter.load() == 256);
+
+    // A task whose group has no budget left does not hide older tasks of
+    // other groups in the same deque (the other worker is busy in that group)
+    ThreadPool pair(2);
+    TaskGroup full(1), open;
+    std::atomic<bool> release{false};
+    std::atomic<bool> older_ran{false};
+    std::atomic<bool> blocked_ran{false};
+    pair.submit(full, [&release] {
+        while (!release.load()) std::this_thread::yield();
+    });
+    pair.submit(open, [&pair, &older_ran, &blocked_ran, &full] {
+        pair.submit([&older_ran] { older_ran = true; });
+        pair.submit(full, [&blocked_ran] { blocked_ran = true; });
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!older_ran.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(older_ran.load());
+    assert(!blocked_ran.load());
+
+    release = true;
+    pair.wait(full);
+    pair.wait(open);
+    assert(blocked_ran.load());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pool_growth() {
+    std::cout << "Testing ThreadPool growth..." << std::endl;
+
+    ThreadPool pool(2);
+    assert(pool.get_thread_count() == 2);
+    pool.reserve_workers(5);
+    assert(pool.get_thread_count() == 5);
+    // Smaller requests keep the pool as it is
+    pool.reserve_workers(3);
+    assert(pool.get_thread_count() == 5);
+
+    std::atomic<long> counter{0};
+    pool.submit([&pool, &counter] { spawn(pool, counter, 10); });
+    pool.wait_for_completion();
+    assert(counter.load() == (1L << 11) - 1);
+
+    // The shared pool is never rebuilt, whatever parallelism callers ask for
+    ThreadPool& shared = getThreadPool(3);
+    assert(&getThreadPool(2) == &shared);
+    assert(&getThreadPool(4) == &shared);
+    assert(shared.get_thread_count() == 4);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_task_storage();
+    test_deque_sequential();
+    test_deque_concurrent();
+    test_pool_nested_submit();
+    test_pool_parking();
+    test_pool_task_groups();
+    test_pool_caller_helps();
+    test_pool_budget();
+    test_pool_budget_idle_workers();
+    test_pool_growth();
+
+    std::cout << "All thread pool tests passed!" << std::endl;
+    return 0;
+}
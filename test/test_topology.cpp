@@ -0,0 +1,178 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <numeric>
+#include <cassert>
+#include "dpqs/parallel/topology.hpp"
+#include "dpqs/parallel/threadpool.hpp"
+#include "dpqs/parallel/buffer_manager.hpp"
+
+using namespace dual_pivot;
+namespace fs = std::filesystem;
+
+void write_file(const fs::path& path, const std::string& text) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text << "\n";
+}
+
+// Two sockets, one NUMA node and one L3 per socket, CPUs interleaved between
+// the sockets like many BIOSes number them
+fs::path make_fake_sysfs() {
+    fs::path root = fs::temp_directory_path() / "dpqs_fake_sysfs";
+    fs::remove_all(root);
+    write_file(root / "cpu/online", "0-7");
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        fs::path dir = root / ("cpu/cpu" + std::to_string(cpu));
+        int socket = cpu % 2;
+        write_file(dir / "topology/physical_package_id", std::to_string(socket));
+        write_file(dir / "cache/index0/shared_cpu_list", std::to_string(cpu));
+        write_file(dir / "cache/index3/shared_cpu_list", socket == 0 ? "0,2,4,6" : "1,3,5,7");
+        write_file(dir / "cache/index3/id", std::to_string(socket));
+    }
+    write_file(root / "node/online", "0-1");
+    write_file(root / "node/node0/cpulist", "0,2,4,6");
+    write_file(root / "node/node1/cpulist", "1,3,5,7");
+    return root;
+}
+
+void test_parse_cpu_list() {
+    std::cout << "Testing parse_cpu_list..." << std::endl;
+    assert((parse_cpu_list("0-3,8,10-11") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    assert((parse_cpu_list("5") == std::vector<int>{5}));
+    assert(parse_cpu_list("").empty());
+    std::cout << "Passed." << std::endl;
+}
+
+void test_sysfs_topology() {
+    std::cout << "Testing sysfs topology parsing..." << std::endl;
+
+    fs::path root = make_fake_sysfs();
+    CpuTopology topology = CpuTopology::from_sysfs(root.string());
+    assert(topology.cpus().size() == 8);
+    assert(topology.node_count() == 2);
+    for (const auto& info : topology.cpus()) {
+        assert(info.package == info.cpu % 2);
+        assert(info.node == info.cpu % 2);
+        assert(info.llc == info.cpu % 2);
+    }
+
+    // Placement fills one node before the other
+    std::vector<CpuInfo> order = topology.placement();
+    for (int i = 0; i < 8; ++i) {
+        assert(order[i].node == (i < 4 ? 0 : 1));
+    }
+    assert(CpuTopology::distance(order[0], order[1]) == CpuDistance::SameCache);
+    assert(CpuTopology::distance(order[0], order[4]) == CpuDistance::Remote);
+
+    // A missing tree gives an empty topology; the system one is never empty
+    assert(CpuTopology::from_sysfs((root / "missing").string()).cpus().empty());
+    assert(!CpuTopology::system().cpus().empty());
+    fs::remove_all(root);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_steal_order() {
+    std::cout << "Testing topology-aware victim order..." << std::endl;
+
+    // Two nodes with two caches of two CPUs each
+    std::vector<CpuInfo> cpus;
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        CpuInfo info;
+        info.cpu = cpu;
+        info.node = cpu / 4;
+        info.package = cpu / 4;
+        info.llc = cpu / 2;
+        cpus.push_back(info);
+    }
+    ThreadPool pool(8, false, CpuTopology(cpus));
+
+    for (size_t worker = 0; worker < 8; ++worker) {
+        std::vector<size_t> order = pool.get_steal_order(worker);
+        assert(order.size() == 7 + ThreadPool::CALLER_SLOTS);
+        CpuInfo home = pool.get_worker_cpu(worker);
+
+        // Distances never decrease along the order, caller slots come last
+        int previous = 0;
+        for (size_t k = 0; k < 7; ++k) {
+            assert(order[k] < 8 && order[k] != worker);
+            int d = static_cast<int>(CpuTopology::distance(home, pool.get_worker_cpu(order[k])));
+            assert(d >= previous);
+            previous = d;
+        }
+        assert(CpuTopology::distance(home, pool.get_worker_cpu(order[0])) == CpuDistance::SameCache);
+        assert(CpuTopology::distance(home, pool.get_worker_cpu(order[6])) == CpuDistance::Remote);
+        for (size_t k = 7; k < order.size(); ++k) {
+            assert(order[k] >= ThreadPool::MAX_WORKERS);
+        }
+    }
+
+    // The pool still runs work with the custom topology
+    std::atomic<long> counter{0};
+    for (int t = 0; t < 100; ++t) {
+        pool.submit([&counter] { counter++; });
+    }
+    pool.wait_for_completion();
+    assert(counter.load() == 100);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_pinned_pool() {
+    std::cout << "Testing pinned workers..." << std::endl;
+
+    ThreadPool pool(2, true);
+    std::atomic<long> counter{0};
+    for (int t = 0; t < 100; ++t) {
+        pool.submit([&counter] { counter++; });
+    }
+    pool.wait_for_completion();
+    assert(counter.load() == 100);
+    std::cout << "Passed." << std::endl;
+}
+
+void test_scratch_buffer() {
+    std::cout << "Testing ScratchBuffer first touch..." << std::endl;
+
+    // Large enough for the parallel first touch
+    std::size_t count = MIN_FIRST_TOUCH_BYTES / sizeof(long) * 2 + 3;
+    ScratchBuffer<long> buffer(count, true);
+    assert(buffer.size() == count);
+    std::iota(buffer.data(), buffer.data() + count, 0L);
+    assert(buffer.data()[count - 1] == static_cast<long>(count - 1));
+
+    // One chunk per thread of the sort's budget, run as tasks of the sort's group...
+    ThreadPool& pool = getThreadPool();
+    TaskGroup group(2);
+    long executed = pool.get_tasks_executed();
+    ScratchBuffer<long> sort_buffer(count, group);
+    assert(group.done());
+    assert(pool.get_tasks_executed() - executed == 2);
+
+    // ...or of the running task's group
+    executed = pool.get_tasks_executed();
+    pool.submit(group, [count] { ScratchBuffer<long> nested(count, true); });
+    pool.wait(group);
+    assert(pool.get_tasks_executed() - executed == 3);
+
+    // Non-trivial types are value-initialized
+    ScratchBuffer<std::string> strings(10, true);
+    for (std::size_t i = 0; i < strings.size(); ++i) {
+        assert(strings.data()[i].empty());
+    }
+
+    ScratchBuffer<int> empty(0);
+    assert(empty.data() == nullptr);
+    std::cout << "Passed." << std::endl;
+}
+
+int main() {
+    test_parse_cpu_list();
+    test_sysfs_topology();
+    test_steal_order();
+    test_pinned_pool();
+    test_scratch_buffer();
+
+    std::cout << "All topology tests passed!" << std::endl;
+    return 0;
+}